@@ -50,6 +50,7 @@ Application::Application(char *infile) {
 	srand (time(NULL));
 	par->setparams(infile);
 	log = new Log(par);
+	metrics = new Metrics(par);
 	en = new EmulNet(par);
 	en1 = new EmulNet(par);
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
@@ -65,8 +66,9 @@ Application::Application(char *infile) {
 		Address joinaddr;
 		joinaddr = getjoinaddr();
 		addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
-		mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
-		mp2[i] = new MP2Node(memberNode, par, en1, log, addressOfMemberNode);
+		mp1[i] = new MP1Node(memberNode, par, en, log, metrics, addressOfMemberNode);
+		mp2[i] = new MP2Node(memberNode, par, en1, log, metrics, addressOfMemberNode);
+		mp1[i]->subscribe(mp2[i]);
 		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
 		log->LOG(&(mp2[i]->getMemberNode()->addr), "APP MP2");
 		delete addressOfMemberNode;
@@ -86,6 +88,7 @@ Application::~Application() {
 	}
 	free(mp1);
 	free(mp2);
+	delete metrics;
 	delete par;
 }
 
@@ -118,16 +121,20 @@ int Application::run()
 		}
 		// Fail some nodes
 		//fail();
-	}
 
-	// Clean up
-	en->ENcleanup();
-	en1->ENcleanup();
+		// Export the metrics every METRICS_INTERVAL ticks
+		metrics->tick();
+	}
+	metrics->dump();
 
+	// Clean up, the network last as the nodes leaving still send
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
 	}
 
+	en->ENcleanup();
+	en1->ENcleanup();
+
 	return SUCCESS;
 }
 
@@ -371,12 +378,8 @@ void Application::fail() {
  */
 Address Application::getjoinaddr(void){
 	//trace.funcEntry("Application::getjoinaddr");
-    Address joinaddr;
-    joinaddr.init();
-    *(int *)(&(joinaddr.addr))=1;
-    *(short *)(&(joinaddr.addr[4]))=0;
     //trace.funcExit("Application::getjoinaddr", SUCCESS);
-    return joinaddr;
+    return Address::fromIdPort(1, 0);
 }
 
 /**
@@ -392,6 +395,20 @@ int Application::findARandomNodeThatIsAlive() {
 	return number;
 }
 
+/**
+ * FUNCTION NAME: stopNode
+ *
+ * DESCRIPTION: Fail node i. With GRACEFUL_LEAVE it first hands its keys off and leaves the group.
+ */
+void Application::stopNode(int i) {
+	if ( par->GRACEFUL_LEAVE ) {
+		mp2[i]->handoff();
+		mp1[i]->finishUpThisNode();
+	}
+	mp2[i]->getMemberNode()->bFailed = true;
+	mp1[i]->getMemberNode()->bFailed = true;
+}
+
 /**
  * FUNCTION NAME: initTestKVPairs
  *
@@ -544,8 +561,7 @@ void Application::readTest() {
 		}
 		if ( failedOneNode ) {
 			log->LOG(&mp2[nodeToFail]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->bFailed = true;
-			mp1[nodeToFail]->getMemberNode()->bFailed = true;
+			stopNode(nodeToFail);
 			cout<<endl<<"Failed a replica node"<<endl;
 		}
 		else {
@@ -618,8 +634,7 @@ void Application::readTest() {
 				for ( int i = 0; i < nodesToFail.size(); i++ ) {
 					// Fail a node
 					log->LOG(&mp2[nodesToFail.at(i)]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
+					stopNode(nodesToFail.at(i));
 					cout<<endl<<"Failed a replica node"<<endl;
 				}
 			}
@@ -673,8 +688,7 @@ void Application::readTest() {
 					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[i]->getMemberNode()->bFailed = true;
-					mp1[i]->getMemberNode()->bFailed = true;
+					stopNode(i);
 					failedOneNode = true;
 					cout<<endl<<"Failed a non-replica node"<<endl;
 					break;
@@ -789,8 +803,7 @@ void Application::updateTest() {
 		}
 		if ( failedOneNode ) {
 			log->LOG(&mp2[nodeToFail]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->bFailed = true;
-			mp1[nodeToFail]->getMemberNode()->bFailed = true;
+			stopNode(nodeToFail);
 			cout<<endl<<"Failed a replica node"<<endl;
 		}
 		else {
@@ -861,8 +874,7 @@ void Application::updateTest() {
 				for ( int i = 0; i < nodesToFail.size(); i++ ) {
 					// Fail a node
 					log->LOG(&mp2[nodesToFail.at(i)]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
+					stopNode(nodesToFail.at(i));
 					cout<<endl<<"Failed a replica node"<<endl;
 				}
 			}
@@ -915,8 +927,7 @@ void Application::updateTest() {
 					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[i]->getMemberNode()->bFailed = true;
-					mp1[i]->getMemberNode()->bFailed = true;
+					stopNode(i);
 					failedOneNode = true;
 					cout<<endl<<"Failed a non-replica node"<<endl;
 					break;
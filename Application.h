@@ -17,6 +17,7 @@
 #include "MP2Node.h"
 #include "Node.h"
 #include "common.h"
+#include "Metrics.h"
 
 /**
  * global variables
@@ -54,6 +55,7 @@ private:
 	EmulNet *en;
 	EmulNet *en1;
     Log *log;
+	Metrics *metrics;
 	MP1Node **mp1;
 	MP2Node **mp2;
 	Params *par;
@@ -69,6 +71,7 @@ public:
 	void fail();
 	void insertTestKVPairs();
 	int findARandomNodeThatIsAlive();
+	void stopNode(int i);
 	void deleteTest();
 	void readTest();
 	void updateTest();
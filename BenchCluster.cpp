@@ -0,0 +1,133 @@
+/**********************************
+ * FILE NAME: BenchCluster.cpp
+ *
+ * DESCRIPTION: Definition of the MP1Node cluster of the membership benchmarks
+ **********************************/
+
+#include "BenchCluster.h"
+
+/**
+ * Constructor
+ */
+BenchCluster::BenchCluster(int n, double stepRate, double drop): prejoined(false), log(NULL), metrics(NULL), en(NULL) {
+	par = new Params();
+	par->EN_GPSZ = n;
+	par->MAX_NNB = n;
+	par->STEP_RATE = stepRate;
+	par->MAX_MSG_SIZE = 4000;
+	par->globaltime = 0;
+	par->dropmsg = drop > 0;
+	par->MSG_DROP_PROB = drop;
+	par->PORTNUM = 0;
+}
+
+/**
+ * FUNCTION NAME: start
+ *
+ * DESCRIPTION: Create the network and the nodes with the current Params
+ */
+void BenchCluster::start() {
+	log = new Log(par);
+	metrics = new Metrics(par);
+	en = new EmulNet(par);
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		Address address;
+		en->ENinit(&address, par->PORTNUM);
+		nodes.push_back(new MP1Node(new Member, par, en, log, metrics, &address));
+	}
+}
+
+/**
+ * FUNCTION NAME: fullMembership
+ *
+ * DESCRIPTION: Put every node in the group with all the others in its membership list,
+ * 				so the run starts from a converged cluster instead of the joins
+ */
+void BenchCluster::fullMembership() {
+	int n = nodes.size();
+	for ( MP1Node *node : nodes ) {
+		Member *member = node->getMemberNode();
+		Address joinaddr = node->getJoinAddress();
+		node->initThisNode(&joinaddr);
+		member->inGroup = true;
+		for ( int id = 1; id <= n; id++ ) {
+			if ( memcmp(&id, &member->addr.addr[0], sizeof(int)) ) {
+				member->members.add(id, 0, 0, 0);
+			}
+		}
+		member->nnb = n - 1;
+	}
+	prejoined = true;
+}
+
+/**
+ * FUNCTION NAME: joinTime
+ *
+ * DESCRIPTION: Tick node i starts at, -1 for a node fullMembership already started
+ */
+int BenchCluster::joinTime(int i) {
+	return prejoined ? -1 : (int)(par->STEP_RATE * i);
+}
+
+/**
+ * FUNCTION NAME: lastJoin
+ *
+ * DESCRIPTION: Tick the last node starts at
+ */
+int BenchCluster::lastJoin() {
+	return joinTime(par->EN_GPSZ - 1);
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: Application::mp1Run for the current globaltime. Failed nodes are skipped
+ */
+void BenchCluster::tick() {
+	char joinAddress[] = "1:0";
+	int n = nodes.size();
+	for ( int i = 0; i < n; i++ ) {
+		if ( par->getcurrtime() > joinTime(i) && !nodes[i]->getMemberNode()->bFailed ) {
+			nodes[i]->recvLoop();
+		}
+	}
+	for ( int i = n - 1; i >= 0; i-- ) {
+		if ( par->getcurrtime() == joinTime(i) ) {
+			nodes[i]->nodeStart(joinAddress, par->PORTNUM);
+		}
+		else if ( par->getcurrtime() > joinTime(i) && !nodes[i]->getMemberNode()->bFailed ) {
+			nodes[i]->nodeLoop();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: converged
+ *
+ * DESCRIPTION: Whether every node lists all the others
+ */
+bool BenchCluster::converged() {
+	for ( MP1Node *node : nodes ) {
+		if ( node->getMemberNode()->members.size() + 1 < nodes.size() ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Destructor
+ */
+BenchCluster::~BenchCluster() {
+	for ( MP1Node *node : nodes ) {
+		delete node->getMemberNode();
+		delete node;
+	}
+	if ( en ) {
+		en->ENcleanup();
+	}
+	delete en;
+	delete metrics;
+	delete log;
+	delete par;
+}
@@ -0,0 +1,42 @@
+/**********************************
+ * FILE NAME: BenchCluster.h
+ *
+ * DESCRIPTION: Header file of the MP1Node cluster the membership benchmarks
+ * 				(GossipBench, SwimBench, JoinBench) run on
+ **********************************/
+
+#ifndef _BENCHCLUSTER_H_
+#define _BENCHCLUSTER_H_
+
+#include "MP1Node.h"
+
+/**
+ * CLASS NAME: BenchCluster
+ *
+ * DESCRIPTION: n MP1Nodes on one EmulNet, run tick by tick as Application::mp1Run does.
+ * 				The constructor sets up the Params the benchmarks share; set the protocol
+ * 				fields of par (GOSSIP_MODE, GOSSIP_FANOUT, MEMBERSHIP, ...) before start()
+ * 				creates the nodes. Node i joins through 1:0 at STEP_RATE * i, unless
+ * 				fullMembership() put every node in the group with the full list.
+ */
+class BenchCluster {
+private:
+	bool prejoined;
+	int joinTime(int i);
+
+public:
+	Params *par;
+	Log *log;
+	Metrics *metrics;
+	EmulNet *en;
+	vector<MP1Node *> nodes;
+	BenchCluster(int n, double stepRate, double drop);
+	void start();
+	void fullMembership();
+	void tick();
+	int lastJoin();
+	bool converged();
+	virtual ~BenchCluster();
+};
+
+#endif /* _BENCHCLUSTER_H_ */
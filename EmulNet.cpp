@@ -151,7 +151,7 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
 	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
 		emsg = emulnet.buff[i];
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
+		if ( 0 == memcmp(emsg->to.addr, myaddr->addr, sizeof(myaddr->addr)) ) {
 			sz = emsg->size;
 			tmp = (char *) malloc(sz * sizeof(char));
 			memcpy(tmp, (char *)(emsg+1), sz);
@@ -4,15 +4,27 @@
  * DESCRIPTION: Entry class definition
  **********************************/
 #include "Entry.h"
+#include <charconv>
 
 /**
  * constructor
  */
-Entry::Entry(string _value, int _timestamp, ReplicaType _replica){
+Entry::Entry(string _value, int _timestamp, ReplicaType _replica, int _coordinator, bool _deleted){
 	this->delimiter = ":";
 	value = _value;
 	timestamp = _timestamp;
 	replica = _replica;
+	coordinator = _coordinator;
+	deleted = _deleted;
+}
+
+/**
+ * FUNCTION NAME: tombstone
+ *
+ * DESCRIPTION: The entry a delete issued at timestamp by coordinator leaves behind
+ */
+Entry Entry::tombstone(int timestamp, int coordinator) {
+	return Entry("", timestamp, PRIMARY, coordinator, true);
 }
 
 /**
@@ -21,21 +33,70 @@ Entry::Entry(string _value, int _timestamp, ReplicaType _replica){
  * DESCRIPTION: Convert string to get an Entry object
  */
 Entry::Entry(string entry){
-	vector<string> tuple;
 	this->delimiter = ":";
-	size_t pos = entry.find(delimiter);
-	size_t start = 0;
-	while (pos != string::npos) {
-		string field = entry.substr(start, pos-start);
-		tuple.push_back(field);
-		start = pos + delimiter.size();
-		pos = entry.find(delimiter, start);
+	// fields are split from the right so the value may contain the delimiter
+	size_t fourth = entry.rfind(delimiter);
+	size_t third = entry.rfind(delimiter, fourth - 1);
+	size_t second = entry.rfind(delimiter, third - 1);
+	size_t first = entry.rfind(delimiter, second - 1);
+
+	value = entry.substr(0, first);
+	timestamp = stoi(entry.substr(first + 1, second - first - 1));
+	replica = static_cast<ReplicaType>(stoi(entry.substr(second + 1, third - second - 1)));
+	coordinator = stoi(entry.substr(third + 1, fourth - third - 1));
+	deleted = entry.substr(fourth + 1) == "1";
+}
+
+/**
+ * FUNCTION NAME: newerThan
+ *
+ * DESCRIPTION: Compare versions, the coordinator id breaks ties between writes issued at the same time
+ */
+bool Entry::newerThan(const Entry &another) const {
+	if ( timestamp != another.timestamp ) {
+		return timestamp > another.timestamp;
+	}
+	return coordinator > another.coordinator;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Value and version of a serialized entry, read in place without copying it
+ */
+string_view Entry::parse(string_view entry, int *timestamp, int *coordinator) {
+	// value:timestamp:replica:coordinator:deleted, the value may contain ':'
+	size_t fourth = entry.rfind(':');
+	size_t third = entry.rfind(':', fourth - 1);
+	size_t second = entry.rfind(':', third - 1);
+	size_t first = entry.rfind(':', second - 1);
+	from_chars(entry.data() + first + 1, entry.data() + second, *timestamp);
+	from_chars(entry.data() + third + 1, entry.data() + fourth, *coordinator);
+	return entry.substr(0, first);
+}
+
+/**
+ * FUNCTION NAME: olderThan
+ *
+ * DESCRIPTION: Whether a serialized entry has a newer version, read in place without copying it
+ */
+bool Entry::olderThan(string_view another) const {
+	int otherTimestamp = 0;
+	int otherCoordinator = 0;
+	parse(another, &otherTimestamp, &otherCoordinator);
+	if ( timestamp != otherTimestamp ) {
+		return timestamp < otherTimestamp;
 	}
-	tuple.push_back(entry.substr(start));
+	return coordinator < otherCoordinator;
+}
 
-	value = tuple.at(0);
-	timestamp = stoi(tuple.at(1));
-	replica = static_cast<ReplicaType>(stoi(tuple.at(2)));
+/**
+ * FUNCTION NAME: isDeleted
+ *
+ * DESCRIPTION: Whether a serialized entry is a tombstone, the flag is its last character
+ */
+bool Entry::isDeleted(string_view entry) {
+	return !entry.empty() && entry.back() == '1';
 }
 
 /**
@@ -43,6 +104,6 @@ Entry::Entry(string entry){
  *
  * DESCRIPTION: Convert the object to a string representation
  */
-string Entry::convertToString() {
-	return value + delimiter + to_string(timestamp) + delimiter + to_string(replica);
+string Entry::convertToString() const {
+	return value + delimiter + to_string(timestamp) + delimiter + to_string(replica) + delimiter + to_string(coordinator) + delimiter + (deleted ? "1" : "0");
 }
@@ -10,16 +10,28 @@
 /**
  * CLASS NAME: Entry
  *
- * DESCRIPTION: This class describes the entry for each key in the DHT
+ * DESCRIPTION: This class describes the entry for each key in the DHT.
+ * 				(timestamp, coordinator) is the version of the value: the time
+ * 				the write was issued and the id of the node that coordinated it.
+ * 				Replicas keep the entry with the highest version (last writer wins).
+ * 				A delete is kept as a tombstone, an entry without value marked deleted,
+ * 				so an older copy of the key cannot come back over it.
  */
 class Entry{
 public:
 	string value;
 	int timestamp;
 	ReplicaType replica;
+	int coordinator;
+	bool deleted;
 	string delimiter;
 
 	Entry(string entry);
-	Entry(string _value, int _timestamp, ReplicaType _replica);
-	string convertToString();
+	Entry(string _value, int _timestamp, ReplicaType _replica, int _coordinator = 0, bool _deleted = false);
+	static Entry tombstone(int timestamp, int coordinator);
+	bool newerThan(const Entry &another) const;
+	bool olderThan(string_view another) const;
+	static string_view parse(string_view entry, int *timestamp, int *coordinator);
+	static bool isDeleted(string_view entry);
+	string convertToString() const;
 };
@@ -0,0 +1,133 @@
+/**********************************
+ * FILE NAME: GossipBench.cpp
+ *
+ * DESCRIPTION: Bytes per tick of the membership protocol against cluster size, full
+ * 				against delta gossip, then messages, bytes and convergence time of
+ * 				full gossip against the fanout. Nodes join as in Application, every
+ * 				STEP_RATE ticks, and the traffic is measured over WINDOW ticks once all
+ * 				of them are in. Convergence is the ticks from the last join until every
+ * 				node lists all the others. Also reports the smallest membership list at
+ * 				the end, which must be the cluster size minus one.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./GossipBench [largest cluster, default 100] [drop probability, default 0]
+ * 				  [fanout table cluster, default 100]
+ **********************************/
+
+#include "BenchCluster.h"
+
+/*
+ * Macros
+ */
+// ticks measured after the last join
+#define WARMUP 20
+#define WINDOW 20
+// width of the longest bar of the chart
+#define BAR_WIDTH 40
+
+/**
+ * STRUCT NAME: Result
+ *
+ * DESCRIPTION: Traffic of one run
+ */
+struct Result {
+	double bytesPerTick;
+	double messagesPerTick;
+	// -1 if some node never listed all the others
+	int convergence;
+	size_t minMembers;
+};
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Application::mp1Run for n nodes in the given GossipMode and fanout
+ */
+static Result run(int n, int mode, int fanout, double drop) {
+	BenchCluster cluster(n, .25, drop);
+	Params *par = cluster.par;
+	par->GOSSIP_MODE = mode;
+	par->GOSSIP_FANOUT = fanout;
+	cluster.start();
+	Metrics *metrics = cluster.metrics;
+	Counter *bytes = metrics->counter("message_bytes_sent_total", "", Metrics::label("type", "HEARTBEAT"));
+	Counter *messages = metrics->counter("messages_sent_total", "", Metrics::label("type", "HEARTBEAT"));
+
+	int lastJoin = cluster.lastJoin();
+	int start = lastJoin + 1 + WARMUP;
+	int convergence = -1;
+	long bytesBefore = 0;
+	long messagesBefore = 0;
+	for ( par->globaltime = 0; par->globaltime < start + WINDOW; par->globaltime++ ) {
+		if ( par->globaltime == start ) {
+			bytesBefore = bytes->get();
+			messagesBefore = messages->get();
+		}
+		cluster.tick();
+		if ( convergence < 0 && par->globaltime > lastJoin && cluster.converged() ) {
+			convergence = par->globaltime - lastJoin;
+		}
+	}
+
+	Result result;
+	result.bytesPerTick = (double)(bytes->get() - bytesBefore) / WINDOW;
+	result.messagesPerTick = (double)(messages->get() - messagesBefore) / WINDOW;
+	result.convergence = convergence;
+	result.minMembers = n;
+	for ( MP1Node *node : cluster.nodes ) {
+		result.minMembers = min(result.minMembers, node->getMemberNode()->members.size());
+	}
+	return result;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	int largest = argc > 1 ? atoi(argv[1]) : 100;
+	double drop = argc > 2 ? atof(argv[2]) : 0;
+	int fanoutCluster = argc > 3 ? atoi(argv[3]) : 100;
+	srand(1);
+
+	vector<int> sizes;
+	for ( int n : {10, 25, 50, 100, 200, 400} ) {
+		if ( n <= largest ) {
+			sizes.push_back(n);
+		}
+	}
+	vector<pair<Result, Result>> results;
+	for ( int n : sizes ) {
+		results.emplace_back(run(n, FULL_GOSSIP, 0, drop), run(n, DELTA_GOSSIP, 0, drop));
+	}
+
+	printf("HEARTBEAT traffic over %d ticks after all nodes joined, drop probability %.2f\n", WINDOW, drop);
+	printf("%6s %10s %14s %14s %8s %10s %10s %10s %10s\n", "nodes", "msgs/tick", "full B/tick", "delta B/tick", "delta %",
+			"full conv", "delta conv", "full min", "delta min");
+	for ( size_t i = 0; i < sizes.size(); i++ ) {
+		Result &full = results[i].first;
+		Result &delta = results[i].second;
+		printf("%6d %10.0f %14.0f %14.0f %8.1f %10d %10d %10zu %10zu\n", sizes[i], full.messagesPerTick, full.bytesPerTick,
+				delta.bytesPerTick, 100 * delta.bytesPerTick / full.bytesPerTick, full.convergence, delta.convergence,
+				full.minMembers, delta.minMembers);
+	}
+
+	// bytes per tick, log scale so the small clusters stay visible
+	double top = log10(results.back().first.bytesPerTick);
+	printf("\nbytes/tick (log scale, F full, D delta)\n");
+	for ( size_t i = 0; i < sizes.size(); i++ ) {
+		printf("%6d F %-*s %.0f\n", sizes[i], BAR_WIDTH, string((int)(BAR_WIDTH * log10(results[i].first.bytesPerTick) / top), '#').c_str(), results[i].first.bytesPerTick);
+		printf("%6s D %-*s %.0f\n", "", BAR_WIDTH, string((int)(BAR_WIDTH * log10(results[i].second.bytesPerTick) / top), '#').c_str(), results[i].second.bytesPerTick);
+	}
+
+	printf("\nFull gossip for %d nodes against the fanout, 0 is about 70%% of the members\n", fanoutCluster);
+	printf("%6s %10s %14s %10s %10s\n", "fanout", "msgs/tick", "B/tick", "conv", "min");
+	for ( int fanout : {0, 1, 2, 3, 4, 5, 8} ) {
+		Result result = run(fanoutCluster, FULL_GOSSIP, fanout, drop);
+		printf("%6d %10.0f %14.0f %10d %10zu\n", fanout, result.messagesPerTick, result.bytesPerTick,
+				result.convergence, result.minMembers);
+	}
+	return SUCCESS;
+}
@@ -6,21 +6,454 @@
 
 #include "HashTable.h"
 
-HashTable::HashTable() {}
+/**
+ * Constructor
+ */
+HashTable::HashTable(StorageMode mode) {
+	this->mode = mode;
+	this->arena = mode == ARENA_STORAGE ? new SlabArena() : NULL;
+	size = 0;
+	tombstones = 0;
+	compactCursor = 0;
+	compacting = false;
+	stringBytes = 0;
+	allocate(HT_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor
+ */
+HashTable::HashTable(const HashTable &another): HashTable(another.mode) {
+	// entries are inserted again so the copy gets an arena of its own without the dead bytes
+	for ( size_t i = 0; i < another.capacity; i++ ) {
+		if ( another.ctrl[i] >= 0 ) {
+			upsert(another.keyAt(i), another.valueAt(i));
+		}
+	}
+}
+
+/**
+ * Assignment operator overloading
+ */
+HashTable& HashTable::operator =(const HashTable &another) {
+	if ( this != &another ) {
+		HashTable temp(another);
+		swap(mode, temp.mode);
+		swap(ctrl, temp.ctrl);
+		swap(slots, temp.slots);
+		swap(refs, temp.refs);
+		swap(arena, temp.arena);
+		swap(capacity, temp.capacity);
+		swap(size, temp.size);
+		swap(tombstones, temp.tombstones);
+		swap(compactCursor, temp.compactCursor);
+		swap(compacting, temp.compacting);
+		swap(stringBytes, temp.stringBytes);
+	}
+	return *this;
+}
+
+/**
+ * Destructor
+ */
+HashTable::~HashTable() {
+	delete[] ctrl;
+	delete[] slots;
+	delete[] refs;
+	delete arena;
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: The low 7 bits go in the control byte (h2), the rest picks the first group to probe (h1)
+ */
+size_t HashTable::hash(string_view key) {
+	std::hash<string_view> hashFunc;
+	return hashFunc(key);
+}
+
+/**
+ * FUNCTION NAME: heapBytes
+ *
+ * DESCRIPTION: Bytes of the heap buffer of a string, 0 for a short string kept inside the string object
+ */
+size_t HashTable::heapBytes(const string &s) {
+	if ( s.data() >= (const char *)&s && s.data() < (const char *)(&s + 1) ) {
+		return 0;
+	}
+	return s.capacity() + 1;
+}
+
+/**
+ * FUNCTION NAME: match
+ *
+ * DESCRIPTION: Bit i of the result is set if group[i] == h
+ */
+uint32_t HashTable::match(const int8_t *group, int8_t h) {
+#ifdef __SSE2__
+	__m128i g = _mm_loadu_si128((const __m128i *)group);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(h)));
+#else
+	uint32_t mask = 0;
+	for ( int i = 0; i < HT_GROUP_WIDTH; i++ ) {
+		mask |= (uint32_t)(group[i] == h) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * FUNCTION NAME: matchFree
+ *
+ * DESCRIPTION: Bit i of the result is set if group[i] is EMPTY or DELETED
+ */
+uint32_t HashTable::matchFree(const int8_t *group) {
+#ifdef __SSE2__
+	// EMPTY and DELETED are the only negative control bytes
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+	uint32_t mask = 0;
+	for ( int i = 0; i < HT_GROUP_WIDTH; i++ ) {
+		mask |= (uint32_t)(group[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * FUNCTION NAME: allocate
+ *
+ * DESCRIPTION: Fresh control bytes and slot array of newCapacity slots, all EMPTY
+ */
+void HashTable::allocate(size_t newCapacity) {
+	capacity = newCapacity;
+	ctrl = new int8_t[capacity];
+	memset(ctrl, HT_EMPTY, capacity);
+	if ( mode == ARENA_STORAGE ) {
+		slots = NULL;
+		refs = new ArenaSlot[capacity];
+	}
+	else {
+		slots = new Slot[capacity];
+		refs = NULL;
+	}
+}
+
+/**
+ * FUNCTION NAME: keyAt
+ *
+ * DESCRIPTION: Key of a full slot
+ */
+string_view HashTable::keyAt(size_t index) const {
+	if ( mode == ARENA_STORAGE ) {
+		return arena->get(refs[index].key);
+	}
+	return slots[index].first;
+}
+
+/**
+ * FUNCTION NAME: valueAt
+ *
+ * DESCRIPTION: Value of a full slot
+ */
+string_view HashTable::valueAt(size_t index) const {
+	if ( mode == ARENA_STORAGE ) {
+		return refs[index].value != ARENA_NULL_REF ? arena->get(refs[index].value) : string_view();
+	}
+	return slots[index].second;
+}
+
+/**
+ * FUNCTION NAME: setValue
+ *
+ * DESCRIPTION: Replace the value of a full slot. In the arena the new value is appended and the old one released.
+ */
+void HashTable::setValue(size_t index, string_view value) {
+	if ( mode == ARENA_STORAGE ) {
+		uint32_t old = refs[index].value;
+		// append first, value may point into the old one
+		refs[index].value = arena->put(value);
+		if ( old != ARENA_NULL_REF ) {
+			arena->release(old);
+		}
+	}
+	else {
+		stringBytes -= heapBytes(slots[index].second);
+		slots[index].second.assign(value);
+		stringBytes += heapBytes(slots[index].second);
+	}
+}
+
+/**
+ * FUNCTION NAME: probe
+ *
+ * DESCRIPTION: Probe groups (triangular sequence) for the key.
+ * 				If freeIndex is given it receives the first EMPTY or DELETED slot
+ * 				seen on the way, which is where the key belongs if it is missing.
+ *
+ * RETURNS:
+ * slot index if found
+ * capacity otherwise
+ */
+size_t HashTable::probe(string_view key, size_t h, size_t *freeIndex) {
+	size_t groupMask = capacity / HT_GROUP_WIDTH - 1;
+	size_t group = (h >> 7) & groupMask;
+	int8_t h2 = (int8_t)(h & 0x7F);
+	if ( freeIndex ) {
+		*freeIndex = capacity;
+	}
+	for ( size_t i = 1; ; i++ ) {
+		const int8_t *g = ctrl + group * HT_GROUP_WIDTH;
+		for ( uint32_t mask = match(g, h2); mask; mask &= mask - 1 ) {
+			size_t index = group * HT_GROUP_WIDTH + __builtin_ctz(mask);
+			if ( keyAt(index) == key ) {
+				return index;
+			}
+		}
+		if ( freeIndex && *freeIndex == capacity ) {
+			uint32_t mask = matchFree(g);
+			if ( mask ) {
+				*freeIndex = group * HT_GROUP_WIDTH + __builtin_ctz(mask);
+			}
+		}
+		// A key is never placed past a group that still has an EMPTY slot
+		if ( match(g, HT_EMPTY) || i > groupMask ) {
+			return capacity;
+		}
+		group = (group + i) & groupMask;
+	}
+}
+
+/**
+ * FUNCTION NAME: findFree
+ *
+ * DESCRIPTION: First EMPTY or DELETED slot in the probe sequence of h. The table always has one.
+ */
+size_t HashTable::findFree(size_t h) {
+	size_t groupMask = capacity / HT_GROUP_WIDTH - 1;
+	size_t group = (h >> 7) & groupMask;
+	for ( size_t i = 1; ; i++ ) {
+		uint32_t mask = matchFree(ctrl + group * HT_GROUP_WIDTH);
+		if ( mask ) {
+			return group * HT_GROUP_WIDTH + __builtin_ctz(mask);
+		}
+		group = (group + i) & groupMask;
+	}
+}
+
+/**
+ * FUNCTION NAME: rehash
+ *
+ * DESCRIPTION: Move every entry into a fresh table of newCapacity slots, dropping the tombstones
+ */
+void HashTable::rehash(size_t newCapacity) {
+	int8_t *oldCtrl = ctrl;
+	Slot *oldSlots = slots;
+	ArenaSlot *oldRefs = refs;
+	size_t oldCapacity = capacity;
+
+	tombstones = 0;
+	// slots move around, a compaction in progress starts over (moved strings are not moved twice)
+	compactCursor = 0;
+	allocate(newCapacity);
+	for ( size_t i = 0; i < oldCapacity; i++ ) {
+		if ( oldCtrl[i] >= 0 ) {
+			if ( mode == ARENA_STORAGE ) {
+				size_t h = hash(arena->get(oldRefs[i].key));
+				size_t index = findFree(h);
+				ctrl[index] = (int8_t)(h & 0x7F);
+				refs[index] = oldRefs[i];
+			}
+			else {
+				size_t h = hash(oldSlots[i].first);
+				size_t index = findFree(h);
+				ctrl[index] = (int8_t)(h & 0x7F);
+				slots[index].first.swap(oldSlots[i].first);
+				slots[index].second.swap(oldSlots[i].second);
+			}
+		}
+	}
+	delete[] oldCtrl;
+	delete[] oldSlots;
+	delete[] oldRefs;
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Free the slot at index
+ */
+void HashTable::erase(size_t index) {
+	// If the group still has an EMPTY slot no probe ever went past it, so this slot can be EMPTY too
+	const int8_t *g = ctrl + (index & ~(size_t)(HT_GROUP_WIDTH - 1));
+	if ( match(g, HT_EMPTY) ) {
+		ctrl[index] = HT_EMPTY;
+	}
+	else {
+		ctrl[index] = HT_DELETED;
+		tombstones++;
+	}
+	if ( mode == ARENA_STORAGE ) {
+		arena->release(refs[index].key);
+		if ( refs[index].value != ARENA_NULL_REF ) {
+			arena->release(refs[index].value);
+		}
+	}
+	else {
+		stringBytes -= heapBytes(slots[index].first) + heapBytes(slots[index].second);
+		string().swap(slots[index].first);
+		string().swap(slots[index].second);
+	}
+	size--;
+}
 
-HashTable::~HashTable() {}
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Look the key up without copying anything
+ *
+ * RETURNS:
+ * true and the value in *value if found
+ * false otherwise
+ */
+bool HashTable::find(string_view key, string_view *value) {
+	size_t index = probe(key, hash(key), NULL);
+	if ( index == capacity ) {
+		return false;
+	}
+	*value = valueAt(index);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: reserve
+ *
+ * DESCRIPTION: Make room for one more key. Only called once a probe found the key missing,
+ * 				so updating an existing key never resizes the table
+ *
+ * RETURNS:
+ * true if the table was rehashed, which moves every slot
+ */
+bool HashTable::reserve() {
+	// keep the load (entries and tombstones) under 7/8
+	if ( (size + tombstones + 1) * 8 > capacity * 7 ) {
+		rehash((size + 1) * 16 > capacity * 7 ? capacity * 2 : capacity);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: insertAt
+ *
+ * DESCRIPTION: Insert the missing key with an empty value, at the free slot its probe found (or capacity)
+ *
+ * RETURNS:
+ * slot index
+ */
+size_t HashTable::insertAt(string_view key, size_t h, size_t freeIndex) {
+	if ( reserve() || freeIndex == capacity ) {
+		// the rehash moved every slot, or every probed group was full of other keys
+		freeIndex = findFree(h);
+	}
+	if ( ctrl[freeIndex] == HT_DELETED ) {
+		tombstones--;
+	}
+	ctrl[freeIndex] = (int8_t)(h & 0x7F);
+	if ( mode == ARENA_STORAGE ) {
+		refs[freeIndex].key = arena->put(key);
+		refs[freeIndex].value = ARENA_NULL_REF;
+	}
+	else {
+		stringBytes -= heapBytes(slots[freeIndex].first);
+		slots[freeIndex].first.assign(key);
+		stringBytes += heapBytes(slots[freeIndex].first);
+	}
+	size++;
+	return freeIndex;
+}
+
+/**
+ * FUNCTION NAME: findOrInsert
+ *
+ * DESCRIPTION: Returns the slot of the key, inserting the key with an empty value if it is missing.
+ * 				The caller then fills the value with setValue.
+ *
+ * RETURNS:
+ * (slot index, true if the key was inserted)
+ */
+pair<size_t, bool> HashTable::findOrInsert(string_view key) {
+	size_t h = hash(key);
+	size_t freeIndex;
+	size_t index = probe(key, h, &freeIndex);
+	if ( index != capacity ) {
+		return make_pair(index, false);
+	}
+	return make_pair(insertAt(key, h, freeIndex), true);
+}
 
 /**
  * FUNCTION NAME: create
  *
  * DESCRIPTION: This function inserts they (key,value) pair into the local hash table
+ * 				An existing key keeps its value
  *
  * RETURNS:
  * true on SUCCESS
  * false in FAILURE
  */
-bool HashTable::create(string key, string value) {
-	hashTable.emplace(key, value);
+bool HashTable::create(string_view key, string_view value) {
+	pair<size_t, bool> slot = findOrInsert(key);
+	if ( slot.second ) {
+		setValue(slot.first, value);
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: upsert
+ *
+ * DESCRIPTION: Insert the key or replace its value in place
+ *
+ * RETURNS:
+ * true if the key was inserted
+ * false if an existing value was replaced
+ */
+bool HashTable::upsert(string_view key, string_view value) {
+	pair<size_t, bool> slot = findOrInsert(key);
+	setValue(slot.first, value);
+	return slot.second;
+}
+
+/**
+ * FUNCTION NAME: upsertIf
+ *
+ * DESCRIPTION: Insert the key or replace its value, in one probe, if accept agrees.
+ * 				accept gets the stored value, or NULL if the key is missing, before it is
+ * 				overwritten. A missing key accept turns down is not inserted.
+ *
+ * RETURNS:
+ * true if the value was written
+ * false otherwise
+ */
+bool HashTable::upsertIf(string_view key, string_view value, const function<bool(const string_view *)> &accept) {
+	size_t h = hash(key);
+	size_t freeIndex;
+	size_t index = probe(key, h, &freeIndex);
+	if ( index != capacity ) {
+		string_view old = valueAt(index);
+		if ( !accept(&old) ) {
+			return false;
+		}
+	}
+	else if ( accept(NULL) ) {
+		index = insertAt(key, h, freeIndex);
+	}
+	else {
+		return false;
+	}
+	setValue(index, value);
 	return true;
 }
 
@@ -33,13 +466,11 @@ bool HashTable::create(string key, string value) {
  * string value if found
  * else it returns a NULL
  */
-string HashTable::read(string key) {
-	map<string, string>::iterator search;
-
-	search = hashTable.find(key);
-	if ( search != hashTable.end() ) {
+string HashTable::read(string_view key) {
+	string_view value;
+	if ( find(key, &value) ) {
 		// Value found
-		return search->second;
+		return string(value);
 	}
 	else {
 		// Value not found
@@ -51,22 +482,20 @@ string HashTable::read(string key) {
  * FUNCTION NAME: update
  *
  * DESCRIPTION: This function updates the given key with the updated value passed in
- * 				if the key is found
+ * 				if the key is found. The value is replaced in place.
  *
  * RETURNS:
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::update(string key, string newValue) {
-	map<string, string>::iterator update;
-
-	if (read(key).empty()) {
+bool HashTable::update(string_view key, string_view newValue) {
+	size_t index = probe(key, hash(key), NULL);
+	if ( index == capacity || valueAt(index).empty() ) {
 		// Key not found
 		return false;
 	}
 	// Key found
-	//update = hashTable.at(key) = newValue;
-	hashTable.at(key) = newValue;
+	setValue(index, newValue);
 	// Update successful
 	return true;
 }
@@ -80,18 +509,13 @@ bool HashTable::update(string key, string newValue) {
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::deleteKey(string key) {
-	uint eraseCount = 0;
-
-	if (read(key).empty()) {
+bool HashTable::deleteKey(string_view key) {
+	size_t index = probe(key, hash(key), NULL);
+	if ( index == capacity || valueAt(index).empty() ) {
 		// Key not found
 		return false;
 	}
-	eraseCount = hashTable.erase(key);
-	if ( eraseCount < 1 ) {
-		// Could not erase
-		return false;
-	}
+	erase(index);
 	// Delete was successful
 	return true;
 }
@@ -106,7 +530,7 @@ bool HashTable::deleteKey(string key) {
  * false otherwise
  */
 bool HashTable::isEmpty() {
-	return hashTable.empty();
+	return size == 0;
 }
 
 /**
@@ -118,7 +542,7 @@ bool HashTable::isEmpty() {
  * size of the table as unit
  */
 unsigned long HashTable::currentSize() {
-	return (unsigned  long)hashTable.size();
+	return (unsigned long)size;
 }
 
 /**
@@ -127,7 +551,19 @@ unsigned long HashTable::currentSize() {
  * DESCRIPTION: Clear all contents from the hash table
  */
 void HashTable::clear() {
-	hashTable.clear();
+	delete[] ctrl;
+	delete[] slots;
+	delete[] refs;
+	if ( arena ) {
+		delete arena;
+		arena = new SlabArena();
+	}
+	size = 0;
+	tombstones = 0;
+	compactCursor = 0;
+	compacting = false;
+	stringBytes = 0;
+	allocate(HT_MIN_CAPACITY);
 }
 
 /**
@@ -138,7 +574,70 @@ void HashTable::clear() {
  * RETURNS:
  * unsigned long count (Should be always 1)
  */
-unsigned long HashTable::count(string key) {
-	return (unsigned long) hashTable.count(key);
+unsigned long HashTable::count(string_view key) {
+	return probe(key, hash(key), NULL) != capacity ? 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: memoryUsage
+ *
+ * DESCRIPTION: Bytes held by the table: control bytes, slots and the arena or the strings' heap buffers.
+ * 				O(1), both the arena and the table keep their byte counts as they change.
+ */
+size_t HashTable::memoryUsage() {
+	if ( mode == ARENA_STORAGE ) {
+		return sizeof(*this) + capacity * (1 + sizeof(ArenaSlot)) + sizeof(SlabArena) + arena->memoryUsage();
+	}
+	return sizeof(*this) + capacity * (1 + sizeof(Slot)) + stringBytes;
 }
 
+/**
+ * FUNCTION NAME: fragmentation
+ *
+ * DESCRIPTION: Fraction of the arena taken by released strings, 0 for inline storage
+ */
+double HashTable::fragmentation() {
+	return mode == ARENA_STORAGE ? arena->fragmentation() : 0;
+}
+
+/**
+ * FUNCTION NAME: compactStep
+ *
+ * DESCRIPTION: Incremental compaction of the arena, meant to run once per tick.
+ * 				Once fragmentation reaches ARENA_COMPACT_RATIO the sparse slabs are
+ * 				marked, then up to budget slots per call have their strings moved
+ * 				out of marked slabs. A marked slab is freed when its last string moves.
+ */
+void HashTable::compactStep(size_t budget) {
+	if ( mode != ARENA_STORAGE ) {
+		return;
+	}
+	if ( !compacting ) {
+		if ( arena->fragmentation() < ARENA_COMPACT_RATIO || 0 == arena->markForCompaction() ) {
+			return;
+		}
+		compacting = true;
+		compactCursor = 0;
+	}
+	size_t last = min(capacity, compactCursor + budget);
+	for ( ; compactCursor < last; compactCursor++ ) {
+		if ( ctrl[compactCursor] < 0 ) {
+			continue;
+		}
+		ArenaSlot &slot = refs[compactCursor];
+		if ( arena->isMarked(slot.key) ) {
+			uint32_t moved = arena->put(arena->get(slot.key));
+			arena->release(slot.key);
+			slot.key = moved;
+		}
+		if ( slot.value != ARENA_NULL_REF && arena->isMarked(slot.value) ) {
+			uint32_t moved = arena->put(arena->get(slot.value));
+			arena->release(slot.value);
+			slot.value = moved;
+		}
+	}
+	if ( compactCursor == capacity ) {
+		arena->freeMarked();
+		compacting = false;
+	}
+}
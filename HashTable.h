@@ -13,26 +13,145 @@
 #include "stdincludes.h"
 #include "common.h"
 #include "Entry.h"
+#include "SlabArena.h"
+#include <stdint.h>
+#include <string_view>
+#include <functional>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Macros
+ */
+// control bytes probed at once, one SSE2 register
+#define HT_GROUP_WIDTH 16
+#define HT_MIN_CAPACITY HT_GROUP_WIDTH
+// control byte of a slot that was never used
+#define HT_EMPTY ((int8_t)-128)
+// control byte of an erased slot, probing continues past it
+#define HT_DELETED ((int8_t)-2)
+// slots looked at by one call to compactStep
+#define HT_COMPACT_BUDGET 4096
+
+/**
+ * Where keys and values are stored
+ */
+enum StorageMode {
+	// std::string pairs in the slot array
+	INLINE_STORAGE,
+	// slots hold two 32-bit references into a SlabArena
+	ARENA_STORAGE
+};
+
+/**
+ * STRUCT NAME: ArenaSlot
+ *
+ * DESCRIPTION: Slot of a table in ARENA_STORAGE mode
+ */
+struct ArenaSlot {
+	uint32_t key;
+	uint32_t value;
+};
 
 /**
  * CLASS NAME: HashTable
  *
- * DESCRIPTION: This class is a wrapper to the map provided by C++ STL.
+ * DESCRIPTION: Open addressing hash table in the style of Swiss tables.
+ * 				Every slot has a control byte holding 7 bits of the key's hash
+ * 				(or EMPTY/DELETED). Slots are probed a group of 16 control bytes
+ * 				at a time, so most lookups touch one cache line of control bytes
+ * 				and compare a single key.
+ *
+ * 				Keys and values live either inline in the slot array or, in
+ * 				ARENA_STORAGE mode, in a SlabArena with 8 byte slots referring
+ * 				to them. The arena is compacted a little at a time by compactStep().
+ *
+ * 				Lookups take string_view so callers never build a temporary string,
+ * 				and every operation probes the table once. Views returned by
+ * 				find or the iterator stay valid until the table is next modified.
  *
  */
 class HashTable {
 public:
-	map<string, string> hashTable;
-//public:
-	HashTable();
-	bool create(string key, string value);
-	string read(string key);
-	bool update(string key, string newValue);
-	bool deleteKey(string key);
+	typedef pair<string, string> Slot;
+
+	/**
+	 * CLASS NAME: iterator
+	 *
+	 * DESCRIPTION: Forward iterator over the (key, value) pairs in the table
+	 */
+	class iterator {
+	private:
+		HashTable *table;
+		size_t index;
+		void skipFree() {
+			while ( index < table->capacity && table->ctrl[index] < 0 ) {
+				index++;
+			}
+		}
+	public:
+		iterator(HashTable *table, size_t index): table(table), index(index) { skipFree(); }
+		pair<string_view, string_view> operator *() { return make_pair(table->keyAt(index), table->valueAt(index)); }
+		iterator & operator ++() { index++; skipFree(); return *this; }
+		bool operator !=(const iterator &another) const { return index != another.index; }
+		bool operator ==(const iterator &another) const { return index == another.index; }
+	};
+
+private:
+	StorageMode mode;
+	// capacity control bytes, capacity is a power of two and a multiple of HT_GROUP_WIDTH
+	int8_t *ctrl;
+	// one of the two slot arrays is used, depending on the mode
+	Slot *slots;
+	ArenaSlot *refs;
+	SlabArena *arena;
+	size_t capacity;
+	size_t size;
+	// slots that are DELETED, they count against the load factor
+	size_t tombstones;
+	// next slot to look at while the arena is being compacted
+	size_t compactCursor;
+	bool compacting;
+	// heap buffers of the strings in INLINE_STORAGE, kept up to date so memoryUsage is O(1)
+	size_t stringBytes;
+
+	static size_t hash(string_view key);
+	static size_t heapBytes(const string &s);
+	static uint32_t match(const int8_t *group, int8_t h);
+	static uint32_t matchFree(const int8_t *group);
+	void allocate(size_t newCapacity);
+	string_view keyAt(size_t index) const;
+	string_view valueAt(size_t index) const;
+	void setValue(size_t index, string_view value);
+	size_t probe(string_view key, size_t h, size_t *freeIndex);
+	size_t findFree(size_t h);
+	bool reserve();
+	size_t insertAt(string_view key, size_t h, size_t freeIndex);
+	pair<size_t, bool> findOrInsert(string_view key);
+	void rehash(size_t newCapacity);
+	void erase(size_t index);
+
+public:
+	HashTable(StorageMode mode = INLINE_STORAGE);
+	HashTable(const HashTable &another);
+	HashTable& operator =(const HashTable &another);
+	bool create(string_view key, string_view value);
+	string read(string_view key);
+	bool update(string_view key, string_view newValue);
+	bool deleteKey(string_view key);
 	bool isEmpty();
 	unsigned long currentSize();
 	void clear();
-	unsigned long count(string key);
+	unsigned long count(string_view key);
+	bool find(string_view key, string_view *value);
+	bool upsert(string_view key, string_view value);
+	bool upsertIf(string_view key, string_view value, const function<bool(const string_view *)> &accept);
+	size_t memoryUsage();
+	double fragmentation();
+	void compactStep(size_t budget);
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, capacity); }
 	virtual ~HashTable();
 };
 
@@ -0,0 +1,169 @@
+/**********************************
+ * FILE NAME: HashTableBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of HashTable, inline and arena storage, against the std::map it replaced
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./HashTableBench [max number of keys, default 10000000]
+ **********************************/
+
+#include "HashTable.h"
+#include <chrono>
+
+/**
+ * FUNCTION NAME: makeKeys
+ *
+ * DESCRIPTION: n distinct pseudo random keys: 4 random characters followed by the index
+ */
+static vector<string> makeKeys(size_t n, unsigned long seed) {
+	static const char alphanum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	vector<string> keys;
+	keys.reserve(n);
+	for ( size_t i = 0; i < n; i++ ) {
+		// the index makes every key distinct, the LCG spreads the prefix
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+		string key;
+		for ( int j = 0; j < 4; j++ ) {
+			key.push_back(alphanum[(seed >> (16 + 6 * j)) % 62]);
+		}
+		key += to_string(i);
+		keys.push_back(key);
+	}
+	return keys;
+}
+
+/**
+ * FUNCTION NAME: nsPerOp
+ *
+ * DESCRIPTION: Average nanoseconds per operation since start
+ */
+static double nsPerOp(chrono::steady_clock::time_point start, size_t ops) {
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+/**
+ * FUNCTION NAME: benchHashTable
+ *
+ * DESCRIPTION: create, read (hit), read (miss), update, delete on HashTable.
+ * 				*memory receives the bytes per key once every key is in, then
+ * 				after every value was rewritten and the arena compacted.
+ */
+static void benchHashTable(StorageMode mode, const vector<string> &keys, const vector<string> &missing, double *result, double *memory) {
+	HashTable ht(mode);
+	size_t found = 0;
+	string_view value;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		ht.create(keys[i], keys[i]);
+	}
+	result[0] = nsPerOp(start, keys.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		found += ht.find(keys[i], &value) ? value.size() : 0;
+	}
+	result[1] = nsPerOp(start, keys.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < missing.size(); i++ ) {
+		found += ht.find(missing[i], &value);
+	}
+	result[2] = nsPerOp(start, missing.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		found += ht.update(keys[i], missing[i]);
+	}
+	result[3] = nsPerOp(start, keys.size());
+	memory[0] = (double)ht.memoryUsage() / keys.size();
+	// rewrite every value twice more, then let the compaction catch up
+	for ( int round = 0; round < 2; round++ ) {
+		for ( size_t i = 0; i < keys.size(); i++ ) {
+			ht.update(keys[i], round ? keys[i] : missing[i]);
+		}
+	}
+	for ( size_t i = 0; i < 4 * keys.size() / HT_COMPACT_BUDGET + 8; i++ ) {
+		ht.compactStep(HT_COMPACT_BUDGET);
+	}
+	memory[1] = (double)ht.memoryUsage() / keys.size();
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		found += ht.deleteKey(keys[i]);
+	}
+	result[4] = nsPerOp(start, keys.size());
+	assert(found > 0 && ht.isEmpty());
+}
+
+/**
+ * FUNCTION NAME: benchMap
+ *
+ * DESCRIPTION: The same operations, written the way the old std::map HashTable did them
+ */
+static void benchMap(const vector<string> &keys, const vector<string> &missing, double *result) {
+	map<string, string> m;
+	size_t found = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		m.emplace(keys[i], keys[i]);
+	}
+	result[0] = nsPerOp(start, keys.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		map<string, string>::iterator search = m.find(keys[i]);
+		found += search != m.end() ? search->second.size() : 0;
+	}
+	result[1] = nsPerOp(start, keys.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < missing.size(); i++ ) {
+		map<string, string>::iterator search = m.find(missing[i]);
+		found += search != m.end() ? search->second.size() : 0;
+	}
+	result[2] = nsPerOp(start, missing.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		map<string, string>::iterator search = m.find(keys[i]);
+		if ( search != m.end() ) {
+			search->second = missing[i];
+			found++;
+		}
+	}
+	result[3] = nsPerOp(start, keys.size());
+	start = chrono::steady_clock::now();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		found += m.erase(keys[i]);
+	}
+	result[4] = nsPerOp(start, keys.size());
+	assert(found > 0 && m.empty());
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	size_t maxKeys = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+	const char *ops[5] = {"create", "read hit", "read miss", "update", "delete"};
+
+	printf("%10s %-10s %12s %12s %12s %8s\n", "keys", "op", "std::map ns", "inline ns", "arena ns", "speedup");
+	for ( size_t n = 1000; n <= maxKeys; n *= 10 ) {
+		vector<string> keys = makeKeys(n, 1);
+		vector<string> missing = makeKeys(n, 2);
+		// same index suffixes, different prefixes: make sure none collides with a real key
+		for ( size_t i = 0; i < n; i++ ) {
+			missing[i][0] = '_';
+		}
+		double inlineResult[5];
+		double arenaResult[5];
+		double mapResult[5];
+		double inlineMemory[2];
+		double arenaMemory[2];
+		benchMap(keys, missing, mapResult);
+		benchHashTable(INLINE_STORAGE, keys, missing, inlineResult, inlineMemory);
+		benchHashTable(ARENA_STORAGE, keys, missing, arenaResult, arenaMemory);
+		for ( int i = 0; i < 5; i++ ) {
+			printf("%10zu %-10s %12.1f %12.1f %12.1f %7.2fx\n", n, ops[i], mapResult[i], inlineResult[i], arenaResult[i], mapResult[i] / inlineResult[i]);
+		}
+		printf("%10zu %-10s %12s %12.1f %12.1f\n", n, "B/key", "", inlineMemory[0], arenaMemory[0]);
+		printf("%10zu %-10s %12s %12.1f %12.1f\n", n, "B/key churn", "", inlineMemory[1], arenaMemory[1]);
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,97 @@
+/**********************************
+ * FILE NAME: JoinBench.cpp
+ *
+ * DESCRIPTION: Time to full membership of heartbeat gossip against the cluster size and
+ * 				the number of seeds. Nodes join as in Application, every STEP_RATE ticks,
+ * 				each through a seed it picks at random, and gossip their full list to
+ * 				GOSSIP_FANOUT 3 members (the watermarks of delta gossip take O(members^2)
+ * 				memory per node at these sizes). Reports the ticks from the last join until
+ * 				every node lists all the others, the JOINREP messages and bytes per join,
+ * 				and the joins the busiest seed answered.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./JoinBench [cluster sizes, default 100 400 1000]
+ **********************************/
+
+#include "BenchCluster.h"
+
+/*
+ * Macros
+ */
+// ticks after the last join the membership is given to converge
+#define CONVERGENCE_LIMIT 300
+
+/**
+ * STRUCT NAME: Result
+ *
+ * DESCRIPTION: Join cost and convergence of one run
+ */
+struct Result {
+	// -1 if some node never listed all the others
+	int convergence;
+	double joinrepsPerJoin;
+	double joinrepBytesPerJoin;
+	long busiestSeed;
+};
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Application::mp1Run for n nodes joining through the given number of seeds
+ */
+static Result run(int n, int seeds) {
+	BenchCluster cluster(n, .25, 0);
+	Params *par = cluster.par;
+	par->GOSSIP_FANOUT = 3;
+	par->SEEDS = seeds;
+	cluster.start();
+	Metrics *metrics = cluster.metrics;
+	Counter *joinreps = metrics->counter("messages_sent_total", "", Metrics::label("type", "JOINREP"));
+	Counter *joinrepBytes = metrics->counter("message_bytes_sent_total", "", Metrics::label("type", "JOINREP"));
+
+	Result result = {-1, 0, 0, 0};
+	int lastJoin = cluster.lastJoin();
+	for ( par->globaltime = 0; par->globaltime <= lastJoin + CONVERGENCE_LIMIT; par->globaltime++ ) {
+		cluster.tick();
+		if ( par->globaltime > lastJoin && cluster.converged() ) {
+			result.convergence = par->globaltime - lastJoin;
+			break;
+		}
+	}
+
+	result.joinrepsPerJoin = (double)joinreps->get() / (n - 1);
+	result.joinrepBytesPerJoin = (double)joinrepBytes->get() / (n - 1);
+	for ( int i = 0; i < min(seeds, n); i++ ) {
+		string node = Metrics::label("node", cluster.nodes[i]->getMemberNode()->addr.getAddress());
+		result.busiestSeed = max(result.busiestSeed, metrics->counter("joins_served_total", "", node)->get());
+	}
+	return result;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	vector<int> sizes;
+	for ( int i = 1; i < argc; i++ ) {
+		sizes.push_back(min(atoi(argv[i]), MAX_NODES));
+	}
+	if ( sizes.empty() ) {
+		sizes = {100, 400, MAX_NODES};
+	}
+	srand(1);
+
+	printf("Full heartbeat gossip with GOSSIP_FANOUT 3, a join every 0.25 ticks\n");
+	printf("%6s %6s %12s %14s %16s %14s\n", "nodes", "seeds", "full after", "JOINREP/join", "JOINREP B/join", "busiest seed");
+	for ( int n : sizes ) {
+		for ( int seeds : {1, 4, 16} ) {
+			Result result = run(n, seeds);
+			printf("%6d %6d %12d %14.2f %16.1f %14ld\n", n, seeds, result.convergence, result.joinrepsPerJoin,
+					result.joinrepBytesPerJoin, result.busiestSeed);
+		}
+	}
+	return SUCCESS;
+}
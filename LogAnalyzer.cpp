@@ -0,0 +1,596 @@
+/**********************************
+ * FILE NAME: LogAnalyzer.cpp
+ *
+ * DESCRIPTION: Single pass analyzer of dbg.log. Computes the checks of
+ * 				KVStoreGrader.sh, per-key replica counts and per-transaction
+ * 				coordinator/replica agreement.
+ *
+ * RUN PROCEDURE:
+ * $ ./LogAnalyzer [-v] <create|delete|read|update> [dbg.log]
+ *
+ * The last line printed is "GRADE <points>".
+ **********************************/
+
+#include "stdincludes.h"
+#include "common.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string_view>
+#include <unordered_map>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Macros
+ */
+#define RF 3
+#define QUORUM 2
+#define INVALID_KEY "invalidKey"
+#define NUM_OPS (DELETE + 1)
+
+static const char *opNames[NUM_OPS] = {"create", "read", "update", "delete"};
+
+/**
+ * STRUCT NAME: Operation
+ *
+ * DESCRIPTION: A "<OP> OPERATION KEY: k VALUE: v at time: t" line issued by the Application
+ */
+struct Operation {
+	int time;
+	string_view key;
+	string_view value;
+};
+
+/**
+ * STRUCT NAME: Outcome
+ *
+ * DESCRIPTION: A "<coordinator|server>: <op> <success|fail> ..." line
+ */
+struct Outcome {
+	int time;
+	MessageType op;
+	bool success;
+	bool coordinator;
+	int transID;
+	string_view node;
+	string_view key;
+	string_view value;
+};
+
+/**
+ * STRUCT NAME: KeyStats
+ *
+ * DESCRIPTION: What the log says about one key
+ */
+struct KeyStats {
+	int success[NUM_OPS];
+	// server nodes that created the key, minus the ones that deleted it
+	vector<string_view> replicas;
+	KeyStats() { memset(success, 0, sizeof(success)); }
+};
+
+/**
+ * STRUCT NAME: TransStats
+ *
+ * DESCRIPTION: What the log says about one transaction
+ */
+struct TransStats {
+	MessageType op;
+	// 0: no decision logged, 1: success, -1: fail
+	int decision;
+	int serverSuccess;
+	int serverFail;
+	bool valueMismatch;
+	string_view coordinatorValue;
+	string_view serverValue;
+	TransStats(): op(CREATE), decision(0), serverSuccess(0), serverFail(0), valueMismatch(false) {}
+};
+
+/**
+ * CLASS NAME: LogAnalyzer
+ *
+ * DESCRIPTION: Parses the log once and keeps only aggregates, plus the outcome
+ * 				lines of the operation under test (those are a handful of string views).
+ */
+class LogAnalyzer {
+public:
+	MessageType test;
+	bool verbose;
+	long lines;
+	vector<Operation> ops[NUM_OPS];
+	long successCount[NUM_OPS];
+	// outcomes of the operation under test, in log order
+	vector<Outcome> tested;
+	unordered_map<string_view, KeyStats> keys;
+	unordered_map<int, TransStats> trans;
+
+	LogAnalyzer(MessageType test, bool verbose);
+	void scan(const char *data, size_t size);
+	void parseLine(const char *p, const char *end);
+	void account(const Outcome &o);
+	int grade();
+	int gradeCreate();
+	int gradeDelete();
+	int gradeReadUpdate();
+	void report();
+};
+
+/**
+ * FUNCTION NAME: findNewline
+ *
+ * DESCRIPTION: Returns the first '\n' in [p, end), or end. Compares 16 bytes at a time when SSE2 is available.
+ */
+static const char * findNewline(const char *p, const char *end) {
+#ifdef __SSE2__
+	const __m128i nl = _mm_set1_epi8('\n');
+	while ( p + 16 <= end ) {
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), nl));
+		if ( mask ) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+	const char *q = (const char *)memchr(p, '\n', end - p);
+	return q ? q : end;
+}
+
+/**
+ * FUNCTION NAME: skipPrefix
+ *
+ * DESCRIPTION: If [p, end) starts with prefix, advance p past it and return true
+ */
+static bool skipPrefix(const char *&p, const char *end, const char *prefix) {
+	size_t len = strlen(prefix);
+	if ( (size_t)(end - p) < len || memcmp(p, prefix, len) ) {
+		return false;
+	}
+	p += len;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: parseInt
+ *
+ * DESCRIPTION: Parse a (possibly negative) decimal number and advance p
+ */
+static int parseInt(const char *&p, const char *end) {
+	bool negative = false;
+	int n = 0;
+	if ( p < end && *p == '-' ) {
+		negative = true;
+		p++;
+	}
+	while ( p < end && *p >= '0' && *p <= '9' ) {
+		n = n * 10 + (*p++ - '0');
+	}
+	return negative ? -n : n;
+}
+
+/**
+ * FUNCTION NAME: token
+ *
+ * DESCRIPTION: Returns the characters up to the delimiter (or end) and advances p past it
+ */
+static string_view token(const char *&p, const char *end, char delimiter) {
+	const char *start = p;
+	const char *q = (const char *)memchr(p, delimiter, end - p);
+	if ( NULL == q ) {
+		q = end;
+	}
+	p = q < end ? q + 1 : end;
+	return string_view(start, q - start);
+}
+
+/**
+ * FUNCTION NAME: parseOp
+ *
+ * DESCRIPTION: Parse a lower case operation name followed by a space
+ */
+static bool parseOp(const char *&p, const char *end, MessageType &op) {
+	for ( int i = 0; i < NUM_OPS; i++ ) {
+		const char *q = p;
+		if ( skipPrefix(q, end, opNames[i]) && skipPrefix(q, end, " ") ) {
+			op = (MessageType)i;
+			p = q;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Constructor
+ */
+LogAnalyzer::LogAnalyzer(MessageType test, bool verbose): test(test), verbose(verbose), lines(0) {
+	memset(successCount, 0, sizeof(successCount));
+}
+
+/**
+ * FUNCTION NAME: scan
+ *
+ * DESCRIPTION: One pass over the whole log
+ */
+void LogAnalyzer::scan(const char *data, size_t size) {
+	const char *p = data;
+	const char *end = data + size;
+	while ( p < end ) {
+		const char *eol = findNewline(p, end);
+		parseLine(p, eol);
+		lines++;
+		p = eol + 1;
+	}
+}
+
+/**
+ * FUNCTION NAME: parseLine
+ *
+ * DESCRIPTION: Lines look like " <addr> [<time>] <message>"
+ */
+void LogAnalyzer::parseLine(const char *p, const char *end) {
+	if ( !skipPrefix(p, end, " ") ) {
+		return;
+	}
+	string_view node = token(p, end, ' ');
+	if ( !skipPrefix(p, end, "[") ) {
+		return;
+	}
+	int time = parseInt(p, end);
+	if ( !skipPrefix(p, end, "] ") ) {
+		return;
+	}
+
+	Outcome o;
+	o.time = time;
+	o.node = node;
+	o.coordinator = skipPrefix(p, end, "coordinator: ");
+	if ( o.coordinator || skipPrefix(p, end, "server: ") ) {
+		// <op> <success|fail> at time T, transID=N, key=K[, value=V]
+		if ( !parseOp(p, end, o.op) ) {
+			return;
+		}
+		if ( skipPrefix(p, end, "success") ) {
+			o.success = true;
+		}
+		else if ( skipPrefix(p, end, "fail") ) {
+			o.success = false;
+		}
+		else {
+			return;
+		}
+		token(p, end, ',');
+		if ( !skipPrefix(p, end, " transID=") ) {
+			return;
+		}
+		o.transID = parseInt(p, end);
+		if ( !skipPrefix(p, end, ", key=") ) {
+			return;
+		}
+		o.key = token(p, end, ',');
+		if ( skipPrefix(p, end, " value=") ) {
+			o.value = string_view(p, end - p);
+		}
+		account(o);
+		return;
+	}
+
+	// <OP> OPERATION KEY: k [VALUE: v ]at time: t
+	const char *op = p;
+	const char *q = (const char *)memchr(p, ' ', end - p);
+	if ( NULL == q || !(p = q, skipPrefix(p, end, " OPERATION KEY: ")) ) {
+		return;
+	}
+	for ( int i = 0; i < NUM_OPS; i++ ) {
+		if ( (size_t)(q - op) == strlen(opNames[i]) && 0 == strncasecmp(op, opNames[i], q - op) ) {
+			Operation operation;
+			operation.time = time;
+			operation.key = token(p, end, ' ');
+			if ( skipPrefix(p, end, "VALUE: ") ) {
+				operation.value = token(p, end, ' ');
+			}
+			ops[i].push_back(operation);
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: account
+ *
+ * DESCRIPTION: Fold one outcome line into the key and transaction aggregates
+ */
+void LogAnalyzer::account(const Outcome &o) {
+	if ( o.success ) {
+		successCount[o.op]++;
+	}
+	if ( o.op == test ) {
+		tested.push_back(o);
+	}
+
+	KeyStats &k = keys[o.key];
+	if ( o.success ) {
+		k.success[o.op]++;
+		if ( !o.coordinator && o.op == CREATE ) {
+			if ( find(k.replicas.begin(), k.replicas.end(), o.node) == k.replicas.end() ) {
+				k.replicas.push_back(o.node);
+			}
+		}
+		else if ( !o.coordinator && o.op == DELETE ) {
+			vector<string_view>::iterator r = find(k.replicas.begin(), k.replicas.end(), o.node);
+			if ( r != k.replicas.end() ) {
+				k.replicas.erase(r);
+			}
+		}
+	}
+
+	TransStats &t = trans[o.transID];
+	t.op = o.op;
+	if ( o.coordinator ) {
+		t.decision = o.success ? 1 : -1;
+		t.coordinatorValue = o.value;
+	}
+	else if ( o.success ) {
+		t.serverSuccess++;
+		if ( o.op == READ ) {
+			if ( t.serverSuccess > 1 && t.serverValue != o.value ) {
+				t.valueMismatch = true;
+			}
+			t.serverValue = o.value;
+		}
+	}
+	else {
+		t.serverFail++;
+	}
+}
+
+/**
+ * FUNCTION NAME: gradeCreate
+ *
+ * DESCRIPTION: TEST 1: RF server + 1 coordinator create success for every created key
+ */
+int LogAnalyzer::gradeCreate() {
+	bool pass = successCount[CREATE] == (long)ops[CREATE].size() * (RF + 1);
+	for ( size_t i = 0; pass && i < ops[CREATE].size(); i++ ) {
+		pass = keys[ops[CREATE][i].key].success[CREATE] == RF + 1;
+	}
+	int score = pass ? 3 : 0;
+	cout << "TEST 1: Create 3 replicas of every key" << endl;
+	cout << "TEST 1 SCORE..................: " << score << " / 3" << endl;
+	return score;
+}
+
+/**
+ * FUNCTION NAME: gradeDelete
+ *
+ * DESCRIPTION: TEST 1: RF server + 1 coordinator delete success for every valid key
+ * 				TEST 2: RF server + 1 coordinator delete fail for the invalid key
+ */
+int LogAnalyzer::gradeDelete() {
+	long valid = (long)ops[DELETE].size() - 1;
+	bool pass1 = successCount[DELETE] == valid * (RF + 1);
+	for ( size_t i = 0; pass1 && i < ops[DELETE].size(); i++ ) {
+		if ( ops[DELETE][i].key != INVALID_KEY ) {
+			pass1 = keys[ops[DELETE][i].key].success[DELETE] == RF + 1;
+		}
+	}
+	int fails = 0;
+	for ( size_t i = 0; i < tested.size(); i++ ) {
+		if ( !tested[i].success && tested[i].key == INVALID_KEY ) {
+			fails++;
+		}
+	}
+	bool pass2 = fails == RF + 1;
+	cout << "TEST 1: Delete 3 replicas of every key" << endl;
+	cout << "TEST 2: Attempt delete of an invalid key" << endl;
+	cout << "TEST 1 SCORE..................: " << (pass1 ? 3 : 0) << " / 3" << endl;
+	cout << "TEST 2 SCORE..................: " << (pass2 ? 4 : 0) << " / 4" << endl;
+	return (pass1 ? 3 : 0) + (pass2 ? 4 : 0);
+}
+
+/**
+ * FUNCTION NAME: gradeReadUpdate
+ *
+ * DESCRIPTION: The six read (or update) operations split time into windows.
+ * 				Successes for the first key and fails for the test 3 / invalid key are counted per window.
+ */
+int LogAnalyzer::gradeReadUpdate() {
+	const char *name = test == READ ? "Read" : "Update";
+	vector<Operation> &o = ops[test];
+	const int points[6] = {3, 9, 9, 10, 6, 3};
+	const char *titles[6] = {"TEST 1", "TEST 2", "TEST 3 PART 1", "TEST 3 PART 2", "TEST 4", "TEST 5"};
+	int count[6] = {0, 0, 0, 0, 0, 0};
+	bool pass[6] = {false, false, false, false, false, false};
+
+	stable_sort(o.begin(), o.end(), [](const Operation &a, const Operation &b) { return a.time < b.time; });
+	cout << "TEST 1: " << name << " a key. Check for correct value being " << (test == READ ? "read" : "updated") << " at least in quorum of replicas" << endl;
+
+	if ( o.size() >= 6 ) {
+		cout << "TEST 2: " << name << " a key after failing a replica. Check for correct value being " << (test == READ ? "read" : "updated") << " at least in quorum of replicas" << endl;
+		cout << "TEST 3 PART 1: " << name << " a key after failing two replicas. " << name << " should fail" << endl;
+		cout << "TEST 3 PART 2: " << name << " the key after allowing stabilization protocol to kick in. Check for correct value being " << (test == READ ? "read" : "updated") << " at least in quorum of replicas" << endl;
+		cout << "TEST 4: " << name << " a key after failing a non-replica. Check for correct value being " << (test == READ ? "read" : "updated") << " at least in quorum of replicas" << endl;
+		cout << "TEST 5: Attempt " << (test == READ ? "read" : "update") << " of an invalid key" << endl;
+
+		for ( size_t i = 0; i < tested.size(); i++ ) {
+			const Outcome &t = tested[i];
+			if ( t.success && t.key == o[0].key && t.value == o[0].value ) {
+				if ( t.time >= o[0].time && t.time < o[1].time ) {
+					count[0]++;
+				}
+				else if ( t.time >= o[1].time && t.time < o[2].time ) {
+					count[1]++;
+				}
+				else if ( t.time >= o[3].time && t.time < o[4].time ) {
+					count[3]++;
+				}
+				else if ( t.time >= o[4].time ) {
+					count[4]++;
+				}
+			}
+			else if ( !t.success ) {
+				if ( t.time >= o[2].time && t.time < o[3].time && t.key == o[2].key ) {
+					count[2]++;
+				}
+				else if ( t.time >= o[5].time && t.key == INVALID_KEY ) {
+					count[5]++;
+				}
+			}
+		}
+		pass[0] = count[0] == QUORUM + 1 || count[0] == RF + 1;
+		pass[1] = count[1] == QUORUM + 1;
+		pass[2] = count[2] == 1;
+		pass[3] = count[3] == QUORUM + 1 || count[3] == RF + 1;
+		pass[4] = count[4] == QUORUM + 1 || count[4] == RF + 1;
+		pass[5] = count[5] == QUORUM + 1 || count[5] == RF + 1;
+	}
+
+	int score = 0;
+	for ( int i = 0; i < 6; i++ ) {
+		cout << titles[i] << " SCORE..................: " << (pass[i] ? points[i] : 0) << " / " << points[i] << endl;
+		score += pass[i] ? points[i] : 0;
+	}
+	return score;
+}
+
+/**
+ * FUNCTION NAME: grade
+ *
+ * DESCRIPTION: Run the checks of the test this log was produced by
+ */
+int LogAnalyzer::grade() {
+	switch ( test ) {
+		case CREATE:
+			return gradeCreate();
+		case DELETE:
+			return gradeDelete();
+		case READ:
+		case UPDATE:
+			return gradeReadUpdate();
+		default:
+			return 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: report
+ *
+ * DESCRIPTION: Per-key replica counts and per-transaction coordinator/replica agreement
+ */
+void LogAnalyzer::report() {
+	map<size_t, long> replicaHistogram;
+	for ( unordered_map<string_view, KeyStats>::iterator it = keys.begin(); it != keys.end(); ++it ) {
+		if ( it->second.success[CREATE] ) {
+			replicaHistogram[it->second.replicas.size()]++;
+		}
+	}
+	cout << "Keys created: " << ops[CREATE].size() << endl;
+	for ( map<size_t, long>::iterator it = replicaHistogram.begin(); it != replicaHistogram.end(); ++it ) {
+		cout << "  keys with " << it->first << " replica(s): " << it->second << endl;
+	}
+	if ( verbose ) {
+		for ( unordered_map<string_view, KeyStats>::iterator it = keys.begin(); it != keys.end(); ++it ) {
+			if ( it->second.success[CREATE] && it->second.replicas.size() != RF ) {
+				cout << "    key " << it->first << ": " << it->second.replicas.size() << " replica(s)" << endl;
+			}
+		}
+	}
+
+	long agree = 0, disagree = 0, undecided = 0;
+	for ( unordered_map<int, TransStats>::iterator it = trans.begin(); it != trans.end(); ++it ) {
+		TransStats &t = it->second;
+		bool quorum = t.serverSuccess >= QUORUM;
+		bool ok;
+		if ( t.decision == 0 ) {
+			undecided++;
+			continue;
+		}
+		ok = (t.decision == 1) == quorum && !t.valueMismatch;
+		if ( ok && t.op == READ && t.decision == 1 ) {
+			ok = t.coordinatorValue == t.serverValue;
+		}
+		if ( ok ) {
+			agree++;
+		}
+		else {
+			disagree++;
+			if ( verbose ) {
+				cout << "    transID " << it->first << " (" << opNames[t.op] << "): coordinator " << (t.decision == 1 ? "success" : "fail")
+					 << ", " << t.serverSuccess << " server success, " << t.serverFail << " server fail" << endl;
+			}
+		}
+	}
+	cout << "Transactions: " << trans.size() << ", coordinator agrees with replicas: " << agree
+		 << ", disagrees: " << disagree << ", no coordinator decision: " << undecided << endl;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	bool verbose = false;
+	int arg = 1;
+	if ( arg < argc && 0 == strcmp(argv[arg], "-v") ) {
+		verbose = true;
+		arg++;
+	}
+	if ( arg >= argc ) {
+		cout << "Usage: " << argv[0] << " [-v] <create|delete|read|update> [dbg.log]" << endl;
+		return FAILURE;
+	}
+
+	MessageType test;
+	if ( 0 == strcmp(argv[arg], "create") ) {
+		test = CREATE;
+	}
+	else if ( 0 == strcmp(argv[arg], "delete") ) {
+		test = DELETE;
+	}
+	else if ( 0 == strcmp(argv[arg], "read") ) {
+		test = READ;
+	}
+	else if ( 0 == strcmp(argv[arg], "update") ) {
+		test = UPDATE;
+	}
+	else {
+		cout << "Unknown test " << argv[arg] << endl;
+		return FAILURE;
+	}
+	const char *file = arg + 1 < argc ? argv[arg + 1] : "dbg.log";
+
+	int fd = open(file, O_RDONLY);
+	struct stat st;
+	if ( fd < 0 || fstat(fd, &st) < 0 ) {
+		cout << "Could not open " << file << endl;
+		return FAILURE;
+	}
+	const char *data = NULL;
+	if ( st.st_size > 0 ) {
+		data = (const char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if ( data == MAP_FAILED ) {
+			cout << "Could not map " << file << endl;
+			return FAILURE;
+		}
+		madvise((void *)data, st.st_size, MADV_SEQUENTIAL);
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	LogAnalyzer analyzer(test, verbose);
+	analyzer.scan(data, st.st_size);
+	int grade = analyzer.grade();
+	if ( verbose ) {
+		analyzer.report();
+		long ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+		cout << "Analyzed " << analyzer.lines << " lines (" << st.st_size / (1024 * 1024) << " MB) in " << ms << " ms" << endl;
+	}
+	cout << "GRADE " << grade << endl;
+
+	if ( data ) {
+		munmap((void *)data, st.st_size);
+	}
+	close(fd);
+	return SUCCESS;
+}
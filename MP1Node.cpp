@@ -6,6 +6,7 @@
  **********************************/
 
 #include "MP1Node.h"
+#include "Wire.h"
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -16,7 +17,8 @@
  * You can add new members to the class if you think it
  * is necessary for your logic to work
  */
-MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address) {
+MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Metrics *metrics, Address *address) {
+	static const char *msgTypeNames[DUMMYLASTMSGTYPE] = {"JOINREQ", "JOINREP", "HEARTBEAT", "PING", "PINGREQ", "ACK", "LEAVE"};
 	for( int i = 0; i < 6; i++ ) {
 		NULLADDR[i] = 0;
 	}
@@ -24,7 +26,23 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->emulNet = emul;
 	this->log = log;
 	this->par = params;
+	this->metrics = metrics;
 	this->memberNode->addr = *address;
+	for ( int i = 0; i < DUMMYLASTMSGTYPE; i++ ) {
+		msgsSent[i] = metrics->counter("messages_sent_total", "Messages sent, by type", Metrics::label("type", msgTypeNames[i]));
+		bytesSent[i] = metrics->counter("message_bytes_sent_total", "Bytes sent, by message type", Metrics::label("type", msgTypeNames[i]));
+	}
+	membershipSize = metrics->gauge("membership_size", "Members in the membership list of a node", Metrics::label("node", this->memberNode->addr.getAddress()));
+	heartbeatBytes = metrics->histogram("heartbeat_message_bytes", "Size of the HEARTBEAT messages sent", {32, 64, 128, 256, 512, 1024, 2048});
+	suspicions = metrics->counter("swim_suspicions_total", "Members suspected after a probe got no ACK");
+	refutations = metrics->counter("swim_refutations_total", "Suspicions of itself a member refuted");
+	joinsServed = metrics->counter("joins_served_total", "JOINREQs a seed answered", Metrics::label("node", this->memberNode->addr.getAddress()));
+	sendBuffer.resize(par->MAX_MSG_SIZE);
+	nextSeq = 0;
+	lastProbe = 0;
+	probeIndex = 0;
+	viewEpoch = -1;
+	joinSent = 0;
 }
 
 /**
@@ -118,7 +136,6 @@ int MP1Node::initThisNode(Address *joinaddr) {
  * DESCRIPTION: Join the distributed system
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
-	MessageHdr *msg;
 #ifdef DEBUGLOG
     static char s[1024];
 #endif
@@ -131,11 +148,6 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
         memberNode->inGroup = true;
     }
     else {
-        size_t msgsize = sizeof(MessageHdr) + sizeof(joinaddr->addr) + sizeof(long) + 1;
-        msg = (MessageHdr *) malloc(msgsize * sizeof(char));
-
-        // create JOINREQ message: format of data is {struct Address myaddr}
-
 #ifdef DEBUGLOG
         sprintf(s, "Trying to join...");
         log->LOG(&memberNode->addr, s);
@@ -143,6 +155,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 
         // send JOINREQ message to introducer member
         Send(joinaddr, JOINREQ); 
+        joinSent = par->getcurrtime();
     }
 
     return 1;
@@ -152,12 +165,18 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 /**
  * FUNCTION NAME: finishUpThisNode
  *
- * DESCRIPTION: Wind up this node and clean up state
+ * DESCRIPTION: Wind up this node and clean up state.
+ * 				A node in the group leaves it: every member is sent a LEAVE so it removes
+ * 				this node at once instead of TREMOVE ticks later.
  */
 int MP1Node::finishUpThisNode(){
-   /*
-    * Your code goes here
-    */
+	if ( memberNode->inGroup && !memberNode->bFailed ) {
+		MemberListEntry self(memberNode->addr.getId(), memberNode->addr.getPort(), memberNode->heartbeat, par->getcurrtime());
+		spreadLeave(self, memberNode->members.size());
+	}
+	memberNode->inGroup = false;
+	initMemberListTable(memberNode);
+	return SUCCESS;
 }
 
 /**
@@ -176,12 +195,18 @@ void MP1Node::nodeLoop() {
 
     // Wait until you're in the group...
     if( !memberNode->inGroup ) {
+        // ...asking another seed if this one did not answer
+        if ( par->getcurrtime() - joinSent >= JOIN_TIMEOUT ) {
+            Address joinaddr = getJoinAddress();
+            introduceSelfToGroup(&joinaddr);
+        }
     	return;
     }
 
     // ...then jump in and share your responsibilites!
     nodeLoopOps();
 
+    deliverEvents();
     return;
 }
 
@@ -213,7 +238,12 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
 	/*
 	 * Your code goes here
 	 */
-    MessageHdr* msg = (MessageHdr*) data;
+	bool decoded = decode(data, size, &received);
+	free(data);
+	if ( !decoded ) {
+		return false;
+	}
+	MessageHdr* msg = &received;
 	switch(msg->msgType) {
 		case MsgTypes::JOINREQ:{
             		Joinreq_handler(msg);
@@ -229,17 +259,35 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
             memberNode->inGroup=true;
 		    break;
 		    }
+		case MsgTypes::PING:
+		case MsgTypes::PINGREQ:
+		case MsgTypes::ACK:{
+			swimHandler(msg);
+			break;
+		}
+		case MsgTypes::LEAVE:{
+			leaveHandler(msg);
+			break;
+		}
 		default:{
       		    cout << "....." << endl;
         	}  
         }
-	 
-	 free(msg);
 	 return true;
 }
 void MP1Node::Joinreq_handler(MessageHdr* msg){
+    // a seed still joining has no list to give, the joiner asks another one
+    if ( !memberNode->inGroup ) {
+        return;
+    }
     HB_handler(msg);
-    Send(msg->addr, JOINREP); 
+    if ( SWIM_MEMBERSHIP == par->MEMBERSHIP && msg->memberList.size() ) {
+        // the joiner only sends its own entry, the others learn it through the introducer
+        MemberListEntry &joiner = msg->memberList.back();
+        queueUpdate({joiner.id, joiner.port, joiner.heartbeat, SWIM_ALIVE});
+    }
+    Send(&msg->addr, JOINREP); 
+    joinsServed->inc();
     return;
 }
 void MP1Node::Joinrep_handler(MessageHdr* msg){
@@ -248,50 +296,312 @@ void MP1Node::Joinrep_handler(MessageHdr* msg){
     return;
 }
 void MP1Node::Send(Address* toaddr, MsgTypes t) {
-    MessageHdr* msg = new MessageHdr();
-    msg->msgType = t;
-    for(auto mem:memberNode->memberList){
-        if(mem.timestamp<par->getcurrtime()-TFAIL)continue;
-        else msg->memberList.push_back(mem);
+    // in delta mode a heartbeat skips what the peer already knows, unless it is its full list
+    PeerWatermark *mark = NULL;
+    bool full = true;
+    if ( GOSSIP_MEMBERSHIP == par->MEMBERSHIP && DELTA_GOSSIP == par->GOSSIP_MODE && HEARTBEAT == t ) {
+        mark = &watermark(*toaddr);
+        full = par->getcurrtime() - mark->lastFull >= GOSSIP_FULL_INTERVAL;
+        if ( full ) {
+            mark->lastFull = par->getcurrtime();
+        }
+    }
+    sendEntries.clear();
+    MemberTable &members = memberNode->members;
+    for ( size_t i = 0; i < members.size(); i++ ) {
+        // SWIM does not refresh timestamps, a member is listed until declared dead
+        if(GOSSIP_MEMBERSHIP == par->MEMBERSHIP && members.timestamps[i]<par->getcurrtime()-TFAIL)continue;
+        if ( mark ) {
+            long &known = mark->heartbeats[memberKey(members.ids[i], members.ports[i])];
+            if ( !full && members.heartbeats[i] <= known ) {
+                continue;
+            }
+            known = max(known, members.heartbeats[i]);
+        }
+        sendEntries.push_back(members.entry(i));
+    }
+    sendEntries.push_back({memberNode->addr.getId(),memberNode->addr.getPort(),memberNode->heartbeat,par->getcurrtime()});
+    sort(sendEntries.begin(), sendEntries.end(), [](const MemberListEntry &a, const MemberListEntry &b) {
+        return a.id != b.id ? a.id < b.id : a.port < b.port;
+    });
+    // EmulNet drops a message that does not leave room for its en_msg header
+    size_t capacity = min(sendBuffer.size(), par->MAX_MSG_SIZE - sizeof(en_msg) - 1);
+    for ( size_t next = 0; next < sendEntries.size(); ) {
+        size_t size = encode(t, sendEntries, next, sendBuffer.data(), capacity);
+        if ( !size ) {
+            break;
+        }
+        if ( emulNet->ENsend( &memberNode->addr, toaddr, sendBuffer.data(), size) ) {
+            msgsSent[t]->inc();
+            bytesSent[t]->inc(size);
+            if ( HEARTBEAT == t ) {
+                heartbeatBytes->observe(size);
+            }
+        }
     }
-    int id;
-    short port;
-    memcpy( &id, &(memberNode->addr.addr[0]),sizeof(int));
-    memcpy(&port, &(memberNode->addr.addr[4]),sizeof(short));
-    msg->memberList.push_back({id,port,memberNode->heartbeat,par->getcurrtime()});
-    msg->addr = &memberNode->addr;
-    emulNet->ENsend( &memberNode->addr, toaddr, (char*)msg, sizeof(MessageHdr));    
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Serialize into buffer a message carrying the members of entries from next on,
+ * 				as many as fit in capacity, see MessageHdr. entries must be sorted by id
+ * 				and port. A run that does not fit is cut at the last member that does.
+ *
+ * RETURNS:
+ * bytes written, 0 if not even one member fits. next is moved past the members written.
+ */
+size_t MP1Node::encode(MsgTypes t, vector<MemberListEntry> &entries, size_t &next, char *buffer, size_t capacity) {
+	long now = par->getcurrtime();
+	WireWriter w = {buffer, buffer + capacity, true};
+	w.byte(GOSSIP_WIRE_VERSION);
+	w.byte(t);
+	w.bytes(memberNode->addr.addr, sizeof(memberNode->addr.addr));
+	size_t first = next;
+	uint32_t previous = 0;
+	long heartbeat = 0;
+	while ( w.ok && next < entries.size() ) {
+		MemberListEntry &start = entries[next];
+		size_t length = 1;
+		while ( next + length < entries.size() && entries[next + length].port == start.port
+				&& entries[next + length].id == start.id + (int)length ) {
+			length++;
+		}
+		char *runStart = w.p;
+		long runHeartbeat = heartbeat;
+		for ( ;; ) {
+			w.varint((uint32_t)start.id - previous);
+			w.zigzag(start.port);
+			w.varint(length);
+			size_t written = 0;
+			for ( ; written < length; written++ ) {
+				MemberListEntry &entry = entries[next + written];
+				w.zigzag((int)(entry.heartbeat - heartbeat));
+				w.varint(max(0L, now - entry.timestamp));
+				if ( !w.ok ) {
+					break;
+				}
+				heartbeat = entry.heartbeat;
+			}
+			if ( written == length ) {
+				break;
+			}
+			// rewrite the run with the members that fit, its count is no longer
+			w.p = runStart;
+			w.ok = written > 0;
+			heartbeat = runHeartbeat;
+			length = written;
+			if ( !w.ok ) {
+				break;
+			}
+		}
+		if ( !w.ok ) {
+			break;
+		}
+		next += length;
+		previous = entries[next - 1].id;
+	}
+	return next > first ? w.p - buffer : 0;
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Decode a received message into msg, reusing its member list.
+ * 				False for another wire version, an unknown type or a malformed message.
+ */
+bool MP1Node::decode(const char *data, size_t size, MessageHdr *msg) {
+	if ( size < GOSSIP_HEADER_SIZE || GOSSIP_WIRE_VERSION != (uint8_t)data[0] || (uint8_t)data[1] >= DUMMYLASTMSGTYPE ) {
+		return false;
+	}
+	long now = par->getcurrtime();
+	WireReader r = {data + 2, data + size, true};
+	msg->msgType = (MsgTypes)data[1];
+	memcpy(msg->addr.addr, r.p, sizeof(msg->addr.addr));
+	r.p += sizeof(msg->addr.addr);
+	uint32_t id = 0;
+	if ( PING == msg->msgType || PINGREQ == msg->msgType || ACK == msg->msgType ) {
+		msg->seq = r.varint();
+		if ( PINGREQ == msg->msgType ) {
+			if ( (size_t)(r.end - r.p) < sizeof(msg->target.addr) ) {
+				return false;
+			}
+			memcpy(msg->target.addr, r.p, sizeof(msg->target.addr));
+			r.p += sizeof(msg->target.addr);
+		}
+		uint64_t count = r.varint();
+		msg->updates.clear();
+		for ( uint64_t i = 0; i < count && r.ok; i++ ) {
+			id += r.varint();
+			short port = r.zigzag();
+			long incarnation = r.varint();
+			uint8_t state = r.byte();
+			if ( state > SWIM_DEAD ) {
+				return false;
+			}
+			msg->updates.push_back({(int)id, port, incarnation, (SwimState)state});
+		}
+		return r.ok && r.p == r.end;
+	}
+	long heartbeat = 0;
+	msg->memberList.clear();
+	while ( r.ok && r.p < r.end ) {
+		id += r.varint();
+		short port = r.zigzag();
+		uint64_t length = r.varint();
+		// a member takes at least two bytes
+		if ( 0 == length || length > (uint64_t)(r.end - r.p) / 2 ) {
+			return false;
+		}
+		for ( uint64_t i = 0; i < length && r.ok; i++ ) {
+			heartbeat += r.zigzag();
+			long timestamp = now - r.varint();
+			msg->memberList.push_back({(int)(id + i), port, heartbeat, timestamp});
+		}
+		id += length - 1;
+	}
+	return r.ok;
 }
 void MP1Node::HB_handler(MessageHdr* msg){
+	PeerWatermark *mark = GOSSIP_MEMBERSHIP == par->MEMBERSHIP && DELTA_GOSSIP == par->GOSSIP_MODE ? &watermark(msg->addr) : NULL;
 	for (auto mem : msg->memberList){
+		if ( departed.size() && departed.count(memberKey(mem.id, mem.port)) ) {
+			continue;
+		}
 		if(!Update_hb(mem)){
 		    Add2list(mem);
 		}
+		if ( mark ) {
+			long &known = mark->heartbeats[memberKey(mem.id, mem.port)];
+			known = max(known, mem.heartbeat);
+		}
 	}
     return;
 }
+
+/**
+ * FUNCTION NAME: watermark
+ *
+ * DESCRIPTION: Delta gossip state of a peer. A new peer is due its full list
+ * 				GOSSIP_FULL_INTERVAL ticks later, its first heartbeat has everything anyway.
+ */
+PeerWatermark &MP1Node::watermark(Address &peer) {
+	pair<unordered_map<long, PeerWatermark>::iterator, bool> found = watermarks.try_emplace(memberKey(peer.getId(), peer.getPort()));
+	if ( found.second ) {
+		found.first->second.lastFull = par->getcurrtime();
+	}
+	return found.first->second;
+}
+
+/**
+ * FUNCTION NAME: forgetMember
+ *
+ * DESCRIPTION: Drop the delta gossip state of a removed member, so it is announced
+ * 				again in full if it comes back with a restarted heartbeat
+ */
+void MP1Node::forgetMember(long key) {
+	watermarks.erase(key);
+	for ( pair<const long, PeerWatermark> &peer : watermarks ) {
+		peer.second.heartbeats.erase(key);
+	}
+}
 bool MP1Node::Update_hb(MemberListEntry &entry) {
-    for (int i = 0; i < memberNode->memberList.size(); i++){
-        if(memberNode->memberList[i].id == entry.id && memberNode->memberList[i].port == entry.port){
-            if(entry.heartbeat > memberNode->memberList[i].heartbeat){
-                memberNode->memberList[i].heartbeat=entry.heartbeat;
-                memberNode->memberList[i].timestamp=this->par->getcurrtime();
-		}
-            return 1;
-        }      
-    } 
-    return 0;
+    MemberTable &members = memberNode->members;
+    int row = members.find(entry.id, entry.port);
+    if ( row < 0 ) {
+        return 0;
+    }
+    if(entry.heartbeat > members.heartbeats[row]){
+        long interval = this->par->getcurrtime() - members.timestamps[row];
+        if ( interval > 0 ) {
+            members.arrivals[row].add(interval);
+        }
+        members.heartbeats[row]=entry.heartbeat;
+        members.timestamps[row]=this->par->getcurrtime();
+    }
+    return 1;
+}
+
+/**
+ * FUNCTION NAME: expired
+ *
+ * DESCRIPTION: Whether a member is due for removal: its phi reached PHI_THRESHOLD or, with
+ * 				no threshold or before a first heartbeat interval, TREMOVE ticks without news
+ */
+bool MP1Node::expired(size_t row) {
+	MemberTable &members = memberNode->members;
+	long elapsed = par->getcurrtime() - members.timestamps[row];
+	if ( par->PHI_THRESHOLD > 0 && members.arrivals[row].count ) {
+		return members.arrivals[row].phi(elapsed) >= par->PHI_THRESHOLD;
+	}
+	return elapsed >= TREMOVE;
 }
 void MP1Node::Add2list(MemberListEntry &entry) {
-    Address temp = Address(to_string(entry.id) + ":" + to_string(entry.port));
-    
+    Address temp = Address::fromIdPort(entry.id, entry.port);
+
     if (!(temp == memberNode->addr)) {
         log->logNodeAdd(&memberNode->addr, &temp);
         ++memberNode->nnb;
-        memberNode->memberList.push_back(entry);
+        memberNode->members.add(entry.id, entry.port, entry.heartbeat, entry.timestamp);
+        publishEvent(temp, MEMBER_JOINED);
     }
     return ;
 }
+/**
+ * FUNCTION NAME: publishEvent
+ *
+ * DESCRIPTION: Record a membership change for the listeners, a join or a removal starts an epoch
+ */
+void MP1Node::publishEvent(Address &addr, MembershipChange change) {
+	if ( MEMBER_SUSPECTED != change ) {
+		memberNode->epoch++;
+	}
+	pending.push_back({addr, change, memberNode->epoch});
+}
+
+/**
+ * FUNCTION NAME: subscribe
+ *
+ * DESCRIPTION: Deliver the membership changes to a listener from the next batch on
+ */
+void MP1Node::subscribe(MembershipListener *listener) {
+	listeners.push_back(listener);
+}
+
+/**
+ * FUNCTION NAME: deliverEvents
+ *
+ * DESCRIPTION: Deliver the changes of this tick to every listener and refresh memberList
+ * 				if the epoch moved
+ */
+void MP1Node::deliverEvents() {
+	if ( pending.empty() ) {
+		return;
+	}
+	for ( MembershipListener *listener : listeners ) {
+		for ( MembershipEvent &event : pending ) {
+			switch ( event.change ) {
+				case MEMBER_JOINED:
+					listener->onJoin(event.addr);
+					break;
+				case MEMBER_SUSPECTED:
+					listener->onSuspect(event.addr);
+					break;
+				case MEMBER_FAILED:
+				case MEMBER_LEFT:
+					listener->onLeave(event.addr, MEMBER_LEFT == event.change);
+					break;
+			}
+		}
+		listener->onEpoch(memberNode->epoch);
+	}
+	pending.clear();
+	if ( viewEpoch != memberNode->epoch ) {
+		memberNode->members.view(memberNode->memberList);
+		viewEpoch = memberNode->epoch;
+	}
+}
+
 /**
  * FUNCTION NAME: nodeLoopOps
  *
@@ -304,31 +614,450 @@ void MP1Node::nodeLoopOps() {
 	/*
 	 * Your code goes here
 	 */
+    if ( SWIM_MEMBERSHIP == par->MEMBERSHIP ) {
+        swimLoop();
+        return;
+    }
     memberNode->heartbeat++;
-    int left=0;
-    for (int i = 0;i < memberNode->memberList.size() ; i++) {
-        if(par->getcurrtime() - memberNode->memberList[i].timestamp  < TREMOVE) {
-        	MemberListEntry t=memberNode->memberList[left];
-        	memberNode->memberList[left++]=memberNode->memberList[i];
-        	memberNode->memberList[i]=t;
+    MemberTable &members = memberNode->members;
+    // backwards, the row a removal moves in was already checked
+    for (int i = members.size() - 1; i >= 0; i--) {
+        if(expired(i)) {
+            Address temp = members.addrs[i];
+            log->logNodeRemove(&memberNode->addr, &temp);
+            publishEvent(temp, MEMBER_FAILED);
+            forgetMember(memberKey(members.ids[i], members.ports[i]));
+            members.remove(i);
+            --memberNode->nnb;
         }
     }
-    for(int i=memberNode->memberList.size()-1;i>=left;i--){
-    	Address temp = Address(to_string(memberNode->memberList[i].id) + ":" + to_string(memberNode->memberList[i].port));
-	log->logNodeRemove(&memberNode->addr, &temp);
-	memberNode->memberList.pop_back();
-	--memberNode->nnb;
+    for ( map<long, int>::iterator it = departed.begin(); it != departed.end(); ) {
+        if ( par->getcurrtime() - it->second >= TREMOVE ) {
+            it = departed.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    membershipSize->set(members.size());
+    if ( par->GOSSIP_FANOUT ) {
+        gossip();
+        return;
     }
     // Send PING to the members of memberList
-    for (int i = 0; i < memberNode->memberList.size(); i++) {
+    for (size_t i = 0; i < members.size(); i++) {
     	double x = (double) rand() / (RAND_MAX + 1.0);
     	if(x<0.3)continue;
-        Address temp = Address(to_string(memberNode->memberList[i].id) + ":" + to_string(memberNode->memberList[i].port));
-        Send(&temp, HEARTBEAT);
+        Send(&members.addrs[i], HEARTBEAT);
     }
     return;
 }
 
+/**
+ * FUNCTION NAME: gossip
+ *
+ * DESCRIPTION: Send a HEARTBEAT to GOSSIP_FANOUT members picked uniformly at random, by a
+ * 				partial Fisher-Yates shuffle of peerOrder. The shuffled order is kept from one
+ * 				tick to the next, only a change in the size of the list resets it.
+ */
+void MP1Node::gossip() {
+	MemberTable &members = memberNode->members;
+	int n = members.size();
+	if ( (int)peerOrder.size() != n ) {
+		peerOrder.resize(n);
+		for ( int i = 0; i < n; i++ ) {
+			peerOrder[i] = i;
+		}
+	}
+	int k = min(n, par->GOSSIP_FANOUT);
+	for ( int i = 0; i < k; i++ ) {
+		swap(peerOrder[i], peerOrder[i + rand() % (n - i)]);
+		Send(&members.addrs[peerOrder[i]], HEARTBEAT);
+	}
+}
+
+/**
+ * FUNCTION NAME: swimLoop
+ *
+ * DESCRIPTION: SWIM duties of a tick:
+ * 				1) Declare dead the suspects nobody vouched for in time
+ * 				2) Escalate the probes without an ACK: PINGREQ through SWIM_INDIRECT members
+ * 				   after SWIM_PING_TIMEOUT ticks, suspicion after SWIM_PROBE_TIMEOUT
+ * 				3) Every SWIM_PERIOD ticks, PING the next member of a shuffled round-robin
+ * 				   order, so every member is probed once per round
+ * 				The node's heartbeat is its incarnation, only bumped to refute a suspicion.
+ */
+void MP1Node::swimLoop() {
+	int now = par->getcurrtime();
+	MemberTable &members = memberNode->members;
+	int n = members.size();
+
+	int timeout = (int)(SWIM_SUSPICION_MULT * logMembers() * SWIM_PERIOD);
+	for ( map<long, int>::iterator it = suspects.begin(); it != suspects.end(); ) {
+		long key = it->first;
+		int index = now - it->second >= timeout ? findMember(key) : -1;
+		++it;
+		if ( index >= 0 ) {
+			SwimUpdate update = {members.ids[index], members.ports[index], members.heartbeats[index], SWIM_DEAD};
+			removeMember(index, update.incarnation, false);
+			queueUpdate(update);
+		}
+	}
+
+	for ( map<int, SwimProbe>::iterator it = probes.begin(); it != probes.end(); ) {
+		SwimProbe &probe = it->second;
+		if ( now - probe.started >= SWIM_PROBE_TIMEOUT ) {
+			int index = findMember(memberKey(probe.target.getId(), probe.target.getPort()));
+			if ( index >= 0 ) {
+				suspect(index);
+			}
+			it = probes.erase(it);
+			continue;
+		}
+		if ( !probe.indirect && now - probe.started >= SWIM_PING_TIMEOUT ) {
+			probe.indirect = true;
+			// SWIM_INDIRECT helpers by a partial Fisher-Yates shuffle, skipping the target
+			helperOrder.resize(n);
+			for ( int i = 0; i < n; i++ ) {
+				helperOrder[i] = i;
+			}
+			int sent = 0;
+			for ( int i = 0; i < n && sent < SWIM_INDIRECT; i++ ) {
+				swap(helperOrder[i], helperOrder[i + rand() % (n - i)]);
+				Address &addr = members.addrs[helperOrder[i]];
+				if ( addr == probe.target ) {
+					continue;
+				}
+				sendSwim(&addr, PINGREQ, it->first, &probe.target);
+				sent++;
+			}
+		}
+		++it;
+	}
+
+	for ( map<int, SwimRelay>::iterator it = relays.begin(); it != relays.end(); ) {
+		if ( now - it->second.started >= SWIM_PROBE_TIMEOUT ) {
+			it = relays.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	n = members.size();
+	membershipSize->set(n);
+	if ( 0 == n || now - lastProbe < SWIM_PERIOD ) {
+		return;
+	}
+	lastProbe = now;
+	if ( (int)peerOrder.size() != n || probeIndex >= peerOrder.size() ) {
+		peerOrder.resize(n);
+		for ( int i = 0; i < n; i++ ) {
+			peerOrder[i] = i;
+		}
+		for ( int i = n - 1; i > 0; i-- ) {
+			swap(peerOrder[i], peerOrder[rand() % (i + 1)]);
+		}
+		probeIndex = 0;
+	}
+	SwimProbe probe;
+	probe.target = members.addrs[peerOrder[probeIndex++]];
+	probe.started = now;
+	probe.indirect = false;
+	int seq = nextSeq++;
+	probes[seq] = probe;
+	sendSwim(&probe.target, PING, seq, NULL);
+}
+
+/**
+ * FUNCTION NAME: swimHandler
+ *
+ * DESCRIPTION: Apply the updates a SWIM message carries, and add the sender if it is
+ * 				unknown and not dead, since the updates announcing its join can all have
+ * 				missed this node. Then:
+ * 				PING: ACK it
+ * 				PINGREQ: PING the target, remembering to forward its ACK
+ * 				ACK: forward it if it answers a relayed PING, else close the probe
+ */
+void MP1Node::swimHandler(MessageHdr *msg) {
+	for ( SwimUpdate &update : msg->updates ) {
+		applyUpdate(update);
+	}
+	SwimUpdate sender = {msg->addr.getId(), msg->addr.getPort(), 0, SWIM_ALIVE};
+	applyUpdate(sender);
+	switch ( msg->msgType ) {
+		case PING:
+			sendSwim(&msg->addr, ACK, msg->seq, NULL);
+			break;
+		case PINGREQ: {
+			int seq = nextSeq++;
+			relays[seq] = {msg->addr, msg->seq, par->getcurrtime()};
+			sendSwim(&msg->target, PING, seq, NULL);
+			break;
+		}
+		case ACK: {
+			map<int, SwimRelay>::iterator relay = relays.find(msg->seq);
+			if ( relay != relays.end() ) {
+				sendSwim(&relay->second.requester, ACK, relay->second.seq, NULL);
+				relays.erase(relay);
+			}
+			else {
+				probes.erase(msg->seq);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+ * FUNCTION NAME: sendSwim
+ *
+ * DESCRIPTION: Send a SWIM message with the SWIM_PIGGYBACK updates of the dissemination buffer
+ * 				sent the fewest times. An update leaves the buffer after going out
+ * 				SWIM_RETRANSMIT_MULT * log10(members + 1) times.
+ */
+void MP1Node::sendSwim(Address *toaddr, MsgTypes t, int seq, Address *target) {
+	int limit = (int)ceil(SWIM_RETRANSMIT_MULT * logMembers());
+	size_t count = min((size_t)SWIM_PIGGYBACK, broadcasts.size());
+	partial_sort(broadcasts.begin(), broadcasts.begin() + count, broadcasts.end(),
+			[](const SwimBroadcast &a, const SwimBroadcast &b) { return a.transmits < b.transmits; });
+	sendUpdates.clear();
+	for ( size_t i = 0; i < count; i++ ) {
+		sendUpdates.push_back(broadcasts[i].update);
+		broadcasts[i].transmits++;
+	}
+	broadcasts.erase(remove_if(broadcasts.begin(), broadcasts.end(),
+			[limit](const SwimBroadcast &b) { return b.transmits >= limit; }), broadcasts.end());
+
+	size_t size = encodeSwim(t, seq, target, sendUpdates, sendBuffer.data(), sendBuffer.size());
+	if ( size && emulNet->ENsend(&memberNode->addr, toaddr, sendBuffer.data(), size) ) {
+		msgsSent[t]->inc();
+		bytesSent[t]->inc(size);
+	}
+}
+
+/**
+ * FUNCTION NAME: encodeSwim
+ *
+ * DESCRIPTION: Serialize a SWIM message into buffer, see MessageHdr.
+ * 				Sorts updates by id and port so the ids are small deltas.
+ *
+ * RETURNS:
+ * bytes written, 0 if capacity is too small
+ */
+size_t MP1Node::encodeSwim(MsgTypes t, int seq, Address *target, vector<SwimUpdate> &updates, char *buffer, size_t capacity) {
+	sort(updates.begin(), updates.end(), [](const SwimUpdate &a, const SwimUpdate &b) {
+		return a.id != b.id ? a.id < b.id : a.port < b.port;
+	});
+	WireWriter w = {buffer, buffer + capacity, true};
+	w.byte(GOSSIP_WIRE_VERSION);
+	w.byte(t);
+	w.bytes(memberNode->addr.addr, sizeof(memberNode->addr.addr));
+	w.varint(seq);
+	if ( PINGREQ == t ) {
+		w.bytes(target->addr, sizeof(target->addr));
+	}
+	w.varint(updates.size());
+	uint32_t previous = 0;
+	for ( SwimUpdate &update : updates ) {
+		w.varint((uint32_t)update.id - previous);
+		w.zigzag(update.port);
+		w.varint(update.incarnation);
+		w.byte(update.state);
+		previous = update.id;
+	}
+	return w.ok ? w.p - buffer : 0;
+}
+
+/**
+ * FUNCTION NAME: applyUpdate
+ *
+ * DESCRIPTION: Merge a piggybacked update into the membership list, passing on the ones
+ * 				that changed it. Higher incarnations win, at equal incarnations
+ * 				DEAD > SUSPECT > ALIVE. A suspicion of this node is refuted with
+ * 				a higher incarnation.
+ */
+void MP1Node::applyUpdate(SwimUpdate &update) {
+	long key = memberKey(update.id, update.port);
+	int id = memberNode->addr.getId();
+	short port = memberNode->addr.getPort();
+	if ( memberKey(id, port) == key ) {
+		if ( SWIM_ALIVE != update.state && update.incarnation >= memberNode->heartbeat ) {
+			memberNode->heartbeat = update.incarnation + 1;
+			refutations->inc();
+			queueUpdate({id, port, memberNode->heartbeat, SWIM_ALIVE});
+		}
+		return;
+	}
+
+	int index = findMember(key);
+	if ( index < 0 ) {
+		map<long, long>::iterator tomb = dead.find(key);
+		if ( SWIM_ALIVE == update.state && (tomb == dead.end() || update.incarnation > tomb->second) ) {
+			MemberListEntry entry(update.id, update.port, update.incarnation, par->getcurrtime());
+			Add2list(entry);
+			dead.erase(key);
+			queueUpdate(update);
+		}
+		return;
+	}
+	long &incarnation = memberNode->members.heartbeats[index];
+	bool suspected = suspects.count(key);
+	switch ( update.state ) {
+		case SWIM_ALIVE:
+			if ( update.incarnation > incarnation ) {
+				incarnation = update.incarnation;
+				memberNode->members.timestamps[index] = par->getcurrtime();
+				suspects.erase(key);
+				queueUpdate(update);
+			}
+			break;
+		case SWIM_SUSPECT:
+			if ( update.incarnation > incarnation || (update.incarnation == incarnation && !suspected) ) {
+				incarnation = update.incarnation;
+				if ( !suspected ) {
+					suspects[key] = par->getcurrtime();
+					publishEvent(memberNode->members.addrs[index], MEMBER_SUSPECTED);
+				}
+				queueUpdate(update);
+			}
+			break;
+		case SWIM_DEAD:
+			if ( update.incarnation >= incarnation ) {
+				removeMember(index, update.incarnation, false);
+				queueUpdate(update);
+			}
+			break;
+	}
+}
+
+/**
+ * FUNCTION NAME: queueUpdate
+ *
+ * DESCRIPTION: Put an update in the dissemination buffer, replacing any older one about
+ * 				the same member
+ */
+void MP1Node::queueUpdate(const SwimUpdate &update) {
+	broadcasts.erase(remove_if(broadcasts.begin(), broadcasts.end(), [&update](const SwimBroadcast &b) {
+		return b.update.id == update.id && b.update.port == update.port;
+	}), broadcasts.end());
+	broadcasts.push_back({update, 0});
+}
+
+/**
+ * FUNCTION NAME: suspect
+ *
+ * DESCRIPTION: Start suspecting a member that missed a probe, unless it already is
+ */
+void MP1Node::suspect(size_t row) {
+	MemberTable &members = memberNode->members;
+	long key = memberKey(members.ids[row], members.ports[row]);
+	if ( suspects.count(key) ) {
+		return;
+	}
+	suspects[key] = par->getcurrtime();
+	suspicions->inc();
+	publishEvent(members.addrs[row], MEMBER_SUSPECTED);
+	queueUpdate({members.ids[row], members.ports[row], members.heartbeats[row], SWIM_SUSPECT});
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Remove a member declared dead or that left, remembering its incarnation so
+ * 				older updates do not bring it back
+ */
+void MP1Node::removeMember(size_t index, long incarnation, bool left) {
+	Address addr = memberNode->members.addrs[index];
+	long key = memberKey(addr.getId(), addr.getPort());
+	log->logNodeRemove(&memberNode->addr, &addr);
+	publishEvent(addr, left ? MEMBER_LEFT : MEMBER_FAILED);
+	forgetMember(key);
+	suspects.erase(key);
+	dead[key] = incarnation;
+	memberNode->members.remove(index);
+	--memberNode->nnb;
+}
+
+/**
+ * FUNCTION NAME: leaveHandler
+ *
+ * DESCRIPTION: A member left the group: remove it at once. SWIM spreads the news as a DEAD
+ * 				update, heartbeat gossip passes the LEAVE on to LEAVE_FANOUT members the
+ * 				first time this node hears of it and ignores its heartbeats for TREMOVE ticks.
+ */
+void MP1Node::leaveHandler(MessageHdr *msg) {
+	MemberTable &members = memberNode->members;
+	for ( MemberListEntry &leaver : msg->memberList ) {
+		long key = memberKey(leaver.id, leaver.port);
+		int index = findMember(key);
+		if ( index < 0 ) {
+			continue;
+		}
+		if ( SWIM_MEMBERSHIP == par->MEMBERSHIP ) {
+			long incarnation = max(leaver.heartbeat, members.heartbeats[index]);
+			removeMember(index, incarnation, true);
+			queueUpdate({leaver.id, leaver.port, incarnation, SWIM_DEAD});
+			continue;
+		}
+		Address addr = members.addrs[index];
+		log->logNodeRemove(&memberNode->addr, &addr);
+		publishEvent(addr, MEMBER_LEFT);
+		forgetMember(key);
+		members.remove(index);
+		--memberNode->nnb;
+		departed[key] = par->getcurrtime();
+		spreadLeave(leaver, LEAVE_FANOUT);
+	}
+}
+
+/**
+ * FUNCTION NAME: spreadLeave
+ *
+ * DESCRIPTION: Send a LEAVE about a member to count members picked at random
+ */
+void MP1Node::spreadLeave(MemberListEntry &leaver, int count) {
+	MemberTable &members = memberNode->members;
+	int n = members.size();
+	sendEntries.assign(1, leaver);
+	size_t next = 0;
+	size_t size = encode(LEAVE, sendEntries, next, sendBuffer.data(), sendBuffer.size());
+	if ( !size ) {
+		return;
+	}
+	helperOrder.resize(n);
+	for ( int i = 0; i < n; i++ ) {
+		helperOrder[i] = i;
+	}
+	for ( int i = 0; i < min(n, count); i++ ) {
+		swap(helperOrder[i], helperOrder[i + rand() % (n - i)]);
+		if ( emulNet->ENsend(&memberNode->addr, &members.addrs[helperOrder[i]], sendBuffer.data(), size) ) {
+			msgsSent[LEAVE]->inc();
+			bytesSent[LEAVE]->inc(size);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: findMember
+ *
+ * DESCRIPTION: Row of a member in the membership table, -1 if it is not there
+ */
+int MP1Node::findMember(long key) {
+	return memberNode->members.find((int)(key >> 16), (short)key);
+}
+
+/**
+ * FUNCTION NAME: logMembers
+ *
+ * DESCRIPTION: log10(members + 1), at least 1: how SWIM timeouts and retransmissions scale
+ */
+double MP1Node::logMembers() {
+	return max(1.0, log10(memberNode->members.size() + 2.0));
+}
+
 /**
  * FUNCTION NAME: isNullAddress
  *
@@ -341,16 +1070,16 @@ int MP1Node::isNullAddress(Address *addr) {
 /**
  * FUNCTION NAME: getJoinAddress
  *
- * DESCRIPTION: Returns the Address of the coordinator
+ * DESCRIPTION: Returns the Address of the seed to join through. The nodes of id 1 to SEEDS
+ * 				are the seeds: node 1 starts the group and the other seeds join through it,
+ * 				every other node picks a seed at random so the joins spread over them.
  */
 Address MP1Node::getJoinAddress() {
-    Address joinaddr;
-
-    memset(&joinaddr, 0, sizeof(Address));
-    *(int *)(&joinaddr.addr) = 1;
-    *(short *)(&joinaddr.addr[4]) = 0;
-
-    return joinaddr;
+    int seeds = min(par->SEEDS, par->EN_GPSZ);
+    if ( seeds <= 1 || memberNode->addr.getId() <= seeds ) {
+        return Address::fromIdPort(1, 0);
+    }
+    return Address::fromIdPort(1 + rand() % seeds, 0);
 }
 
 /**
@@ -359,6 +1088,7 @@ Address MP1Node::getJoinAddress() {
  * DESCRIPTION: Initialize the membership list
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
+	memberNode->members.clear();
 	memberNode->memberList.clear();
 }
 
@@ -14,13 +14,38 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "Metrics.h"
 #include <stdlib.h>
 #include <time.h>
+#include <unordered_map>
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 5
+// first byte of every encoded membership message, bumped when the layout changes
+#define GOSSIP_WIRE_VERSION 2
+// version, type and sender address
+#define GOSSIP_HEADER_SIZE 8
+// ticks between two heartbeats to a peer carrying the full list in delta mode
+#define GOSSIP_FULL_INTERVAL 10
+// SWIM: ticks between two probes started by a node
+#define SWIM_PERIOD 2
+// ticks without an ACK before asking SWIM_INDIRECT members to probe the target
+#define SWIM_PING_TIMEOUT 2
+#define SWIM_INDIRECT 3
+// ticks without an ACK, direct or relayed, before the target is suspected
+#define SWIM_PROBE_TIMEOUT 6
+// a suspect is declared dead after SWIM_SUSPICION_MULT * log10(members + 1) periods,
+// and an update is piggybacked SWIM_RETRANSMIT_MULT * log10(members + 1) times
+#define SWIM_SUSPICION_MULT 4
+#define SWIM_RETRANSMIT_MULT 4
+// updates piggybacked on one message
+#define SWIM_PIGGYBACK 8
+// members a node passes a LEAVE on to the first time it hears of it
+#define LEAVE_FANOUT 3
+// ticks a joiner waits for a JOINREP before sending its JOINREQ to another seed
+#define JOIN_TIMEOUT 5
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -33,18 +58,126 @@ enum MsgTypes{
     JOINREQ,
     JOINREP,
     HEARTBEAT,
+    PING,
+    PINGREQ,
+    ACK,
+    LEAVE,
     DUMMYLASTMSGTYPE
 };
 
+/**
+ * How members detect failures
+ */
+enum MembershipProtocol {
+	// heartbeats gossiped to many members, removed TREMOVE ticks after the last increase
+	GOSSIP_MEMBERSHIP,
+	// SWIM: one probe per SWIM_PERIOD, indirect probes, suspicion and piggybacked updates
+	SWIM_MEMBERSHIP
+};
+
+/**
+ * State of a member in a SWIM update
+ */
+enum SwimState {
+	SWIM_ALIVE,
+	SWIM_SUSPECT,
+	SWIM_DEAD
+};
+
+/**
+ * STRUCT NAME: SwimUpdate
+ *
+ * DESCRIPTION: A membership update piggybacked on SWIM messages. The incarnation is bumped
+ * 				by a member refuting a suspicion, and orders the updates about it.
+ */
+struct SwimUpdate {
+	int id;
+	short port;
+	long incarnation;
+	SwimState state;
+};
+
+/**
+ * STRUCT NAME: SwimBroadcast
+ *
+ * DESCRIPTION: An update in the dissemination buffer and the messages it went out on
+ */
+struct SwimBroadcast {
+	SwimUpdate update;
+	int transmits;
+};
+
+/**
+ * STRUCT NAME: SwimProbe
+ *
+ * DESCRIPTION: A probe this node started, waiting for an ACK
+ */
+struct SwimProbe {
+	Address target;
+	int started;
+	bool indirect;
+};
+
+/**
+ * STRUCT NAME: SwimRelay
+ *
+ * DESCRIPTION: A PING sent on behalf of another node, whose ACK is forwarded to it
+ */
+struct SwimRelay {
+	Address requester;
+	int seq;
+	int started;
+};
+
+/**
+ * What a HEARTBEAT carries
+ */
+enum GossipMode {
+	// every member heard from in the last TFAIL ticks
+	FULL_GOSSIP,
+	// only the members whose heartbeat the peer has not seen from or sent to this node,
+	// and the full list every GOSSIP_FULL_INTERVAL ticks to repair lost messages.
+	// Saves nothing while every member bumps its heartbeat each tick, see Readme.txt
+	DELTA_GOSSIP
+};
+
+/**
+ * STRUCT NAME: PeerWatermark
+ *
+ * DESCRIPTION: What a peer knows of the membership as far as this node can tell: the highest
+ * 				heartbeat of each member exchanged with it either way, by memberKey, and the
+ * 				last time it was sent the full list
+ */
+struct PeerWatermark {
+	int lastFull;
+	unordered_map<long, long> heartbeats;
+};
+
 /**
  * STRUCT NAME: MessageHdr
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: Header and content of a message, as decoded by MP1Node::decode.
+ * 				On the wire a message is GOSSIP_WIRE_VERSION, the type byte, the 6 bytes
+ * 				of the sender address, then
+ * 				JOINREQ/JOINREP/HEARTBEAT/LEAVE: the members sorted by id and port, in runs
+ * 				of consecutive ids on one port up to the end of the message. A run is the
+ * 				varint delta of its first id from the last id of the previous run, the
+ * 				zigzag port and the varint member count, then per member the zigzag
+ * 				heartbeat delta from the previous member and the varint age of its
+ * 				timestamp in ticks. A full list so costs about two bytes per member, and
+ * 				one too long for MAX_MSG_SIZE goes out in several messages.
+ * 				PING/PINGREQ/ACK: the varint probe seq, for PINGREQ the 6 bytes of the
+ * 				target, and a varint update count and per update, sorted by id and port:
+ * 				the varint id delta, the zigzag port, the varint incarnation and the state
+ * 				A LEAVE carries the one member that left, with its last heartbeat.
  */
 typedef struct MessageHdr {
 	enum MsgTypes msgType;
 	vector<MemberListEntry> memberList;
-	Address* addr;
+	Address addr;
+	int seq;
+	Address target;
+	vector<SwimUpdate> updates;
 }MessageHdr;
 
 /**
@@ -58,10 +191,50 @@ private:
 	Log *log;
 	Params *par;
 	Member *memberNode;
+	Metrics *metrics;
 	char NULLADDR[6];
+	// per message type counters, indexed by MsgTypes
+	Counter *msgsSent[DUMMYLASTMSGTYPE];
+	Counter *bytesSent[DUMMYLASTMSGTYPE];
+	Gauge *membershipSize;
+	Histogram *heartbeatBytes;
+	// reused by Send and recvCallBack so a message costs no allocation once they have grown
+	vector<MemberListEntry> sendEntries;
+	vector<char> sendBuffer;
+	MessageHdr received;
+	// indices into the membership list, the first GOSSIP_FANOUT of them are this tick's peers
+	vector<int> peerOrder;
+	// delta gossip state, by memberKey of the peer
+	unordered_map<long, PeerWatermark> watermarks;
+	// SWIM state: probes by seq, next member of peerOrder to probe, relayed PINGs by the
+	// seq they went out with, suspects with the tick they were suspected, dead members
+	// with their last incarnation, and the dissemination buffer
+	int nextSeq;
+	int lastProbe;
+	size_t probeIndex;
+	map<int, SwimProbe> probes;
+	map<int, SwimRelay> relays;
+	map<long, int> suspects;
+	map<long, long> dead;
+	vector<SwimBroadcast> broadcasts;
+	vector<SwimUpdate> sendUpdates;
+	vector<int> helperOrder;
+	// heartbeat gossip: members that left, with the tick this node heard of it, whose
+	// heartbeats still in flight are ignored for TREMOVE ticks
+	map<long, int> departed;
+	// tick of the last JOINREQ sent, a seed that does not answer is given up on after JOIN_TIMEOUT
+	int joinSent;
+	// subscribers to the membership changes, the changes of this tick not delivered yet,
+	// and the epoch memberList was last refreshed at
+	vector<MembershipListener *> listeners;
+	vector<MembershipEvent> pending;
+	long viewEpoch;
+	Counter *suspicions;
+	Counter *refutations;
+	Counter *joinsServed;
 
 public:
-	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
+	MP1Node(Member *, Params *, EmulNet *, Log *, Metrics *, Address *);
 	Member * getMemberNode() {
 		return memberNode;
 	}
@@ -83,9 +256,33 @@ public:
 	void Joinreq_handler(MessageHdr *msg);
 	void Joinrep_handler(MessageHdr *msg);
 	void Send(Address* toaddr, MsgTypes t);
+	size_t encode(MsgTypes t, vector<MemberListEntry> &entries, size_t &next, char *buffer, size_t capacity);
+	bool decode(const char *data, size_t size, MessageHdr *msg);
 	void HB_handler(MessageHdr* msg);
 	bool Update_hb(MemberListEntry &entry);
+	bool expired(size_t row);
 	void Add2list(MemberListEntry &entry);
+	void publishEvent(Address &addr, MembershipChange change);
+	void subscribe(MembershipListener *listener);
+	void deliverEvents();
+	static long memberKey(int id, short port) {
+		return ((long)id << 16) | (unsigned short)port;
+	}
+	PeerWatermark &watermark(Address &peer);
+	void forgetMember(long key);
+	void gossip();
+	void swimLoop();
+	void swimHandler(MessageHdr *msg);
+	void sendSwim(Address *toaddr, MsgTypes t, int seq, Address *target);
+	size_t encodeSwim(MsgTypes t, int seq, Address *target, vector<SwimUpdate> &updates, char *buffer, size_t capacity);
+	void applyUpdate(SwimUpdate &update);
+	void queueUpdate(const SwimUpdate &update);
+	void suspect(size_t row);
+	void removeMember(size_t index, long incarnation, bool left);
+	void leaveHandler(MessageHdr *msg);
+	void spreadLeave(MemberListEntry &leaver, int count);
+	int findMember(long key);
+	double logMembers();
 };
 
 #endif /* _MP1NODE_H_ */
@@ -8,83 +8,223 @@
 /**
  * constructor
  */
-MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet * emulNet, Log * log, Address * address) {
+MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet * emulNet, Log * log, Metrics * metrics, Address * address) {
+	static const char *msgTypeNames[MERKLE + 1] = {"CREATE", "READ", "UPDATE", "DELETE", "REPLY", "READREPLY", "MERKLE"};
 	this->memberNode = memberNode;
 	this->par = par;
 	this->emulNet = emulNet;
 	this->log = log;
-	ht = new HashTable();
+	this->metrics = metrics;
+	ht = new HashTable((StorageMode)par->KV_STORAGE);
+	tree = new MerkleTree();
+	bucketKeys.resize(MERKLE_LEAVES);
 	this->memberNode->addr = *address;
+	memcpy(&coordinatorId, &this->memberNode->addr.addr[0], sizeof(int));
+	nextHint = 0;
+	ringEpoch = -1;
+	membershipEpoch = 0;
+	sendBuffer.resize(par->MAX_MSG_SIZE);
+
+	string node = Metrics::label("node", this->memberNode->addr.getAddress());
+	for ( int i = 0; i <= MERKLE; i++ ) {
+		msgsSent[i] = metrics->counter("messages_sent_total", "Messages sent, by type", Metrics::label("type", msgTypeNames[i]));
+		bytesSent[i] = metrics->counter("message_bytes_sent_total", "Bytes sent, by message type", Metrics::label("type", msgTypeNames[i]));
+	}
+	for ( int i = 0; i <= DELETE; i++ ) {
+		quorumSuccess[i] = metrics->counter("quorum_success_total", "Client requests that reached quorum", Metrics::label("op", msgTypeNames[i]));
+		quorumFailure[i] = metrics->counter("quorum_failure_total", "Client requests that failed or timed out", Metrics::label("op", msgTypeNames[i]));
+	}
+	stabilizationSent = metrics->counter("stabilization_messages_sent_total", "Messages sent by the stabilization protocol");
+	readRepairsSent = metrics->counter("read_repair_messages_sent_total", "Newer values pushed to stale replicas by read coordinators");
+	hintsStored = metrics->counter("hints_stored_total", "Writes a replica did not acknowledge, kept by the coordinator");
+	hintsDelivered = metrics->counter("hints_delivered_total", "Hinted writes acknowledged by their target");
+	hintsDropped = metrics->counter("hints_dropped_total", "Hinted writes dropped after HINT_TTL ticks");
+	malformedMessages = metrics->counter("malformed_messages_total", "Received KV messages that failed to decode");
+	falseRemovalMessages = metrics->counter("false_removal_stabilization_messages_total", "Stabilization messages sent for removing nodes that joined again");
+	hintsPending = metrics->gauge("hints_pending", "Hinted writes a coordinator still has to deliver", node);
+	ringSize = metrics->gauge("ring_size", "Nodes on the ring as seen by a node", node);
+	ownership = metrics->gauge("ring_ownership_ppm", "Share of the ring a node is the first replica of, parts per million", node);
+	keysStored = metrics->gauge("keys_stored", "Keys in the local hash table of a node", node);
+	outstandingRequests = metrics->gauge("outstanding_requests", "Client requests waiting for quorum at a coordinator", node);
+	memoryUsed = metrics->gauge("kv_memory_bytes", "Bytes held by the local hash table of a node", node);
+	fragmentation = metrics->gauge("kv_fragmentation_percent", "Share of the key/value arena taken by dead bytes", node);
+	requestLatency = metrics->histogram("request_latency_ticks", "Ticks from a client request to its quorum decision", {0, 1, 2, 3, 4, 5, 10});
 }
 
 /**
  * Destructor
  */
 MP2Node::~MP2Node() {
+	for ( auto &p : undone ) {
+		delete p.second;
+	}
+	for ( auto &p : decided ) {
+		delete p.second;
+	}
 	delete ht;
+	delete tree;
 	delete memberNode;
 }
 
+/**
+ * FUNCTION NAME: onJoin
+ *
+ * DESCRIPTION: A node joined. Staged until the next updateRing, so the ring and its index
+ * 				only change together.
+ */
+void MP2Node::onJoin(Address &addr) {
+	changes.push_back({addr, MEMBER_JOINED, 0});
+}
+
+/**
+ * FUNCTION NAME: onLeave
+ *
+ * DESCRIPTION: A node was removed, staged like onJoin
+ */
+void MP2Node::onLeave(Address &addr, bool left) {
+	changes.push_back({addr, left ? MEMBER_LEFT : MEMBER_FAILED, 0});
+}
+
+/**
+ * FUNCTION NAME: onEpoch
+ *
+ * DESCRIPTION: Membership epoch after a batch of changes, updateRing has work if it moved
+ */
+void MP2Node::onEpoch(long epoch) {
+	membershipEpoch = epoch;
+}
+
 /**
  * FUNCTION NAME: updateRing
  *
  * DESCRIPTION: This function does the following:
- * 				1) Gets the current membership list from the Membership Protocol (MP1Node)
- * 				   The membership list is returned as a vector of Nodes. See Node class in Node.h
- * 				2) Constructs the ring based on the membership list
- * 				3) Calls the Stabilization Protocol
+ * 				1) Returns at once if the membership epoch of MP1Node did not move
+ * 				2) Applies the membership changes delivered since the last call to the ring:
+ * 				   the VNODES tokens of the nodes that joined or were removed are merged into
+ * 				   or dropped from the sorted ring in one pass (rebuildRing)
+ * 				3) Calls the Stabilization Protocol. If the change only removed nodes that left
+ * 				   the group after handing their keys off it pushes no keys, only digests
+ * 				The stabilization messages of a change that removed nodes are charged to
+ * 				them, and counted in falseRemovalMessages if one joins again.
  */
 void MP2Node::updateRing() {
 	/*
 	 * Implement this. Parts of it are already implemented
 	 */
-	vector<Node> curMemList;
 	bool change = false;
 
 	/*
-	 *  Step 1. Get the current membership list from Membership Protocol / MP1
+	 *  Step 1. Nothing to do if the membership did not change
 	 */
-	curMemList = getMembershipList();
+	if(ringEpoch == membershipEpoch)
+		return;
 
 	/*
-	 * Step 2: Construct the ring
+	 * Step 2: Update the ring, kept sorted by hashCode
 	 */
-	// Sort the list based on the hashCode
-
-	curMemList.emplace_back(Node(memberNode->addr));
-	
-	sort(curMemList.begin(), curMemList.end());
+	vector<string> removed;
+	bool handedOff = true;
+	// the last change of a node decides whether its tokens are on the ring
+	map<string, pair<Address, bool>> joined;
+	if(ringEpoch < 0)
+		joined[memberNode->addr.getAddress()] = make_pair(memberNode->addr, true);
+	for(MembershipEvent &event : changes){
+		joined[event.addr.getAddress()] = make_pair(event.addr, MEMBER_JOINED == event.change);
+		if(MEMBER_JOINED == event.change){
+			map<string, long>::iterator removal = removals.find(event.addr.getAddress());
+			if(removal != removals.end()){
+				falseRemovalMessages->inc(removal->second);
+				removals.erase(removal);
+			}
+		}
+		else{
+			removed.push_back(event.addr.getAddress());
+		}
+		handedOff = handedOff && MEMBER_LEFT == event.change;
+	}
+	vector<Node> inserted;
+	vector<Node> erased;
+	for(auto &node : joined){
+		for(int v = 0; v < par->VNODES; v++)
+			(node.second.second ? inserted : erased).emplace_back(node.second.first, v);
+	}
+	changes.clear();
+	ringEpoch = membershipEpoch;
 
 
 	/*
 	 * Step 3: Run the stabilization protocol IF REQUIRED
 	 */
-	// Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
-	bool need_stable;
-	int self=0;
-	
-	for(int i = 0; i < ring.size(); i++){
-		if((memberNode->addr == ring[i].nodeAddress)){
-			self = i;
-			break;
+	// Run stabilization protocol if a node joined or left the ring
+	change = rebuildRing(inserted, erased);
+	ringSize->set(ring.size() / par->VNODES);
+	if(change){
+		swap(oldRingIndex, ringIndex);
+		ringIndex.build(ring);
+		// a token is the first replica of the positions after the previous token, a sole token of all of them
+		double owned = 0;
+		for(size_t i = 0; i < ring.size(); i++){
+			if(!(ring[i].nodeAddress == memberNode->addr))
+				continue;
+			if(ring.size() == 1)
+				owned = 18446744073709551616.0;
+			else
+				owned += ring[i].getHashCode() - ring[(i + ring.size() - 1) % ring.size()].getHashCode();
 		}
+		ownership->set((long)(owned * 1e6 / 18446744073709551616.0));
+		long before = stabilizationSent->get() + msgsSent[MERKLE]->get();
+		stabilizationProtocol(oldRing, handedOff);
+		long sent = stabilizationSent->get() + msgsSent[MERKLE]->get() - before;
+		// split evenly, the first sent % removed.size() nodes take one more so none is lost
+		for(size_t i = 0; i < removed.size(); i++)
+			removals[removed[i]] += sent / removed.size() + (i < sent % removed.size() ? 1 : 0);
 	}
+	
+
+}
 
-	for(int i = 0; i < ring.size(); i++){
-		int j=0;
-		for(;j<curMemList.size();j++){
-			if(ring[i].nodeAddress==curMemList[j].nodeAddress)
-				break;	
+/**
+ * FUNCTION NAME: rebuildRing
+ *
+ * DESCRIPTION: Apply a batch of token changes to the sorted ring in one merge pass. The ring
+ * 				is swapped into oldRing, not copied, and refilled from it without the erased
+ * 				tokens and with the inserted ones that are not there yet. O(ring + changes)
+ * 				for any number of tokens, where inserting or erasing them in place shifts the
+ * 				ring once per token. Once both vectors have grown it allocates nothing.
+ *
+ * RETURNS:
+ * true if a token was inserted or erased
+ */
+bool MP2Node::rebuildRing(vector<Node> &inserted, vector<Node> &erased) {
+	sort(inserted.begin(), inserted.end());
+	sort(erased.begin(), erased.end());
+	oldRing.swap(ring);
+	ring.clear();
+	ring.reserve(oldRing.size() + inserted.size());
+	bool change = false;
+	size_t a = 0;
+	size_t e = 0;
+	for(Node &token : oldRing){
+		for(; a < inserted.size() && inserted[a] < token; a++){
+			ring.push_back(inserted[a]);
+			change = true;
 		}
-		if(j==curMemList.size() && ((self-i+ring.size())%ring.size())<= 2 )
-			need_stable=1;
-	}//prev 2 && next 2
-	ring = curMemList;
-	if(need_stable){
-		stabilizationProtocol();
+		// already on the ring
+		if(a < inserted.size() && !(token < inserted[a]))
+			a++;
+		while(e < erased.size() && erased[e] < token)
+			e++;
+		if(e < erased.size() && !(token < erased[e])){
+			change = true;
+			continue;
+		}
+		ring.push_back(token);
 	}
-	
-
+	for(; a < inserted.size(); a++){
+		ring.push_back(inserted[a]);
+		change = true;
+	}
+	return change;
 }
 
 /**
@@ -101,12 +241,8 @@ vector<Node> MP2Node::getMembershipList() {
 	unsigned int i;
 	vector<Node> curMemList;
 	for ( i = 0 ; i < this->memberNode->memberList.size(); i++ ) {
-		Address addressOfThisMember;
-		int id = this->memberNode->memberList.at(i).getid();
-		short port = this->memberNode->memberList.at(i).getport();
-		memcpy(&addressOfThisMember.addr[0], &id, sizeof(int));
-		memcpy(&addressOfThisMember.addr[4], &port, sizeof(short));
-		curMemList.emplace_back(Node(addressOfThisMember));
+		MemberListEntry &member = this->memberNode->memberList.at(i);
+		curMemList.emplace_back(Node(Address::fromIdPort(member.id, member.port)));
 	}
 	return curMemList;
 }
@@ -115,15 +251,13 @@ vector<Node> MP2Node::getMembershipList() {
  * FUNCTION NAME: hashFunction
  *
  * DESCRIPTION: This functions hashes the key and returns the position on the ring
- * 				HASH FUNCTION USED FOR CONSISTENT HASHING
+ * 				HASH FUNCTION USED FOR CONSISTENT HASHING, see RingHash
  *
  * RETURNS:
- * size_t position on the ring
+ * uint64_t position on the ring
  */
-size_t MP2Node::hashFunction(string key) {
-	std::hash<string> hashFunc;
-	size_t ret = hashFunc(key);
-	return ret%RING_SIZE;
+uint64_t MP2Node::hashFunction(const string &key) {
+	return RingHash::hash(key);
 }
 // transID::fromAddr::CREATE::key::value::ReplicaType
 /**
@@ -139,14 +273,15 @@ void MP2Node::clientCreate(string key, string value) {
 	/*
 	 * Implement this
 	 */
-	 vector<Node>pos=findNodes(key);
+	 const uint32_t *pos=ringIndex.lookup(hashFunction(key));
 	 request* req = new request(g_transID,  this->par->getcurrtime(), CREATE, key, value);
 	 undone[g_transID]=req;
 	 
-	 for(Node& n:pos){
-		 
-		 Message msg (g_transID,this->memberNode->addr,CREATE,key,value,PRIMARY);
-		 emulNet->ENsend(&memberNode->addr, &n.nodeAddress,  msg.toString());
+	 for(int r = 0; pos && r < RING_REPLICAS; r++){
+		 Node &n = ring[pos[r]];
+		 req->replicas.push_back(n.nodeAddress);
+		 Message msg (g_transID,this->memberNode->addr,CREATE,key,value,PRIMARY,this->par->getcurrtime(),coordinatorId);
+		 sendMessage(&n.nodeAddress, msg);
 	 }
 	 ++g_transID;
 }
@@ -165,13 +300,14 @@ void MP2Node::clientRead(string key){
 	/*
 	 * Implement this
 	 */
-	 vector<Node>pos=findNodes(key);
+	 const uint32_t *pos=ringIndex.lookup(hashFunction(key));
 	 request* req = new request(g_transID,  this->par->getcurrtime(), READ, key, "");
 	 undone[g_transID]=req;
-	 for(Node& n:pos){
+	 for(int r = 0; pos && r < RING_REPLICAS; r++){
+		 Node &n = ring[pos[r]];
 		 
 		 Message msg (g_transID,this->memberNode->addr,READ,key);
-		 emulNet->ENsend(&memberNode->addr, &n.nodeAddress,  msg.toString());
+		 sendMessage(&n.nodeAddress, msg);
 	 }
 	 ++g_transID;
 }
@@ -189,13 +325,14 @@ void MP2Node::clientUpdate(string key, string value){
 	/*
 	 * Implement this
 	 */
-	 vector<Node>pos=findNodes(key);
+	 const uint32_t *pos=ringIndex.lookup(hashFunction(key));
 	 request* req = new request(g_transID,  this->par->getcurrtime(), UPDATE, key, value);
 	 undone[g_transID]=req;
-	 for(Node& n:pos){
-		 
-		 Message msg (g_transID,this->memberNode->addr,UPDATE,key,value,PRIMARY);
-		 emulNet->ENsend(&memberNode->addr, &n.nodeAddress,  msg.toString());
+	 for(int r = 0; pos && r < RING_REPLICAS; r++){
+		 Node &n = ring[pos[r]];
+		 req->replicas.push_back(n.nodeAddress);
+		 Message msg (g_transID,this->memberNode->addr,UPDATE,key,value,PRIMARY,this->par->getcurrtime(),coordinatorId);
+		 sendMessage(&n.nodeAddress, msg);
 	 }
 	 ++g_transID;
 }
@@ -213,13 +350,16 @@ void MP2Node::clientDelete(string key){
 	/*
 	 * Implement this
 	 */
-	 vector<Node>pos=findNodes(key);
+	 const uint32_t *pos=ringIndex.lookup(hashFunction(key));
 	 request* req = new request(g_transID,  this->par->getcurrtime(), DELETE, key,"");
 	 undone[g_transID]=req;
-	 for(Node& n:pos){
+	 for(int r = 0; pos && r < RING_REPLICAS; r++){
+		 Node &n = ring[pos[r]];
 		 
-		 Message msg (g_transID,this->memberNode->addr,DELETE,key);
-		 emulNet->ENsend(&memberNode->addr, &n.nodeAddress,  msg.toString());
+		 req->replicas.push_back(n.nodeAddress);
+		 // versioned like a write, replicas keep it as a tombstone
+		 Message msg (g_transID,this->memberNode->addr,DELETE,key,"",PRIMARY,this->par->getcurrtime(),coordinatorId);
+		 sendMessage(&n.nodeAddress, msg);
 	 }
 	 ++g_transID;
 }
@@ -229,18 +369,17 @@ void MP2Node::clientDelete(string key){
  *
  * DESCRIPTION: Server side CREATE API
  * 			   	The function does the following:
- * 			   	1) Inserts key value into the local hash table
+ * 			   	1) Inserts key value into the local hash table, unless it holds a newer version
  * 			   	2) Return true or false based on success or failure
  */
-bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
+bool MP2Node::createKeyValue(string_view key, const Entry &entry) {
 	/*
 	 * Implement this
 	 */
 	// Insert key, value, replicaType into the hash table
-	if( this->ht->create(key, value))
-		return true;
-
-	return false;
+	// a later write already got here: this one is superseded, still a success
+	storeEntry(key, entry, false);
+	return true;
 	
 }
 
@@ -250,16 +389,15 @@ bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
  * DESCRIPTION: Server side READ API
  * 			    This function does the following:
  * 			    1) Read key from local hash table
- * 			    2) Return value
+ * 			    2) Return false if the key is not there. The stored Entry string is not copied,
+ * 			       it may be a tombstone.
  */
-string MP2Node::readKey(string key) {
+bool MP2Node::readKey(string_view key, string_view *value) {
 	/*
 	 * Implement this
 	 */
 	// Read key from local hash table and return value
-	string ret = this->ht->read(key);
-
-	return ret;
+	return this->ht->find(key, value);
 }
 
 /**
@@ -267,18 +405,53 @@ string MP2Node::readKey(string key) {
  *
  * DESCRIPTION: Server side UPDATE API
  * 				This function does the following:
- * 				1) Update the key to the new value in the local hash table
- * 				2) Return true or false based on success or failure
+ * 				1) Update the key to the new value in the local hash table, unless it holds a newer version
+ * 				2) Return true or false based on success or failure, false if the key is missing or deleted
  */
-bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
+bool MP2Node::updateKeyValue(string_view key, const Entry &entry) {
 	/*
 	 * Implement this
 	 */
 	// Update key in local hash table and return true or false
-	if( this->ht->update(key, value))
+	// a later write already got here: this one is superseded, still a success
+	return storeEntry(key, entry, true);
+}
+
+/**
+ * FUNCTION NAME: storeEntry
+ *
+ * DESCRIPTION: Write the entry to the local hash table in one probe, unless the key holds a newer
+ * 				version (or, with onlyLive, no value), and keep the merkle tree in step.
+ * 				The stored version is read in place, nothing is parsed or copied out of the table.
+ * 				A new key is added to bucketKeys, a tombstone written is queued for expireTombstones.
+ *
+ * RETURNS:
+ * true if the key held a value, not a tombstone, before
+ * false otherwise
+ */
+bool MP2Node::storeEntry(string_view key, const Entry &entry, bool onlyLive) {
+	size_t bucket = MerkleTree::bucket(RingHash::hash(key));
+	string stored = entry.convertToString();
+	bool live = false;
+	bool inserted = false;
+	bool written = this->ht->upsertIf(key, stored, [&](const string_view *old) {
+		live = old && !Entry::isDeleted(*old);
+		inserted = !old;
+		if( (onlyLive && !live) || (old && entry.olderThan(*old)))
+			return false;
+		// old points into the table, hash it before the write
+		if( old)
+			tree->toggle(bucket, MerkleTree::itemHash(key, *old));
 		return true;
-	
-	return false;
+	});
+	if( written){
+		tree->toggle(bucket, MerkleTree::itemHash(key, stored));
+		if( inserted)
+			bucketKeys[bucket].emplace_back(key);
+		if( entry.deleted)
+			tombstones.emplace(this->par->getcurrtime(), string(key));
+	}
+	return live;
 }
 
 /**
@@ -286,20 +459,42 @@ bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
  *
  * DESCRIPTION: Server side DELETE API
  * 				This function does the following:
- * 				1) Delete the key from the local hash table
- * 				2) Return true or false based on success or failure
+ * 				1) Replace the value of the key by the tombstone, unless the key holds a newer version.
+ * 				   A missing key gets the tombstone too, in case an older write to it arrives later.
+ * 				2) Return true or false based on success or failure, false if there was no value to delete
  */
-bool MP2Node::deletekey(string key) {
+bool MP2Node::deletekey(string_view key, const Entry &tombstone) {
 	/*
 	 * Implement this
 	 */
 	// Delete the key from the local hash table
+	return storeEntry(key, tombstone, false);
+}
 
-	
-	if (this->ht->deleteKey(key)) 
-		return true;
-		
-	return false;
+/**
+ * FUNCTION NAME: expireTombstones
+ *
+ * DESCRIPTION: Drop the tombstones of deletes issued more than TOMBSTONE_TTL ticks ago.
+ * 				By then no hint, read repair or anti-entropy push can still carry
+ * 				an older copy of the key.
+ */
+void MP2Node::expireTombstones() {
+	int now = this->par->getcurrtime();
+	while(!tombstones.empty() && now - tombstones.front().first > TOMBSTONE_TTL){
+		const string &key = tombstones.front().second;
+		string_view stored;
+		// a later write or a later delete may have replaced it, the later delete is queued itself
+		if(this->ht->find(key, &stored) && Entry::isDeleted(stored) && now - Entry(string(stored)).timestamp > TOMBSTONE_TTL){
+			size_t bucket = MerkleTree::bucket(hashFunction(key));
+			tree->toggle(bucket, MerkleTree::itemHash(key, stored));
+			vector<string> &keys = bucketKeys[bucket];
+			vector<string>::iterator it = find(keys.begin(), keys.end(), key);
+			swap(*it, keys.back());
+			keys.pop_back();
+			this->ht->deleteKey(key);
+		}
+		tombstones.pop();
+	}
 }
 
 /**
@@ -330,72 +525,148 @@ void MP2Node::checkMessages() {
 		size = memberNode->mp2q.front().size;
 		memberNode->mp2q.pop();
 
-		string message(data, data + size);
+		MessageView view;
+		if ( !view.decode(data, size) ) {
+			free(data);
+			malformedMessages->inc();
+			continue;
+		}
 		
 		/*
-		 * Handle the message types here
+		 * Handle the message types here, on the view: the key and value are only
+		 * copied where a stored entry, a request or the log keeps them
 		 */
-		Message msg(message);
-		switch(msg.type){
+		switch(view.type){
 			case MessageType::CREATE:{
-				bool succ = createKeyValue(msg.key, msg.value, msg.replica);
-				if(msg.transID<0)break;
-				reply(msg.transID, &msg.fromAddr, msg.type, succ, "");
+				bool succ = createKeyValue(view.key, Entry(string(view.value), view.timestamp, view.replica, view.coordinator));
+				if(view.transID<0){
+					// hinted writes are acknowledged so the coordinator can drop the hint, still not logged
+					if(view.transID <= HINT_TRANSID_BASE)
+						reply(view.transID, &view.fromAddr, view.type, succ, "");
+					break;
+				}
+				reply(view.transID, &view.fromAddr, view.type, succ, "");
 				if(succ)
-					log->logCreateSuccess(&memberNode->addr, 0, msg.transID, msg.key, msg.value);
-				else log->logCreateFail(&memberNode->addr, 0,  msg.transID, msg.key, msg.value);
+					log->logCreateSuccess(&memberNode->addr, 0, view.transID, string(view.key), string(view.value));
+				else log->logCreateFail(&memberNode->addr, 0,  view.transID, string(view.key), string(view.value));
 				break;
 			}
 			case MessageType::READ:{
-				string content = readKey(msg.key);
-				bool succ = content.size();
-				reply(msg.transID, &msg.fromAddr, msg.type, succ, content);
-				if (succ) log->logReadSuccess(&memberNode->addr, 0, msg.transID, msg.key, content);
-				else log->logReadFail(&memberNode->addr, 0, msg.transID, msg.key);
+				string_view content;
+				bool found = readKey(view.key, &content) && content.size();
+				// a missing key is answered without value or version (timestamp -1),
+				// a tombstone without value, with the version of the delete
+				int timestamp = -1;
+				int coordinator = 0;
+				string_view value = found ? Entry::parse(content, &timestamp, &coordinator) : string_view();
+				bool succ = found && !Entry::isDeleted(content);
+				reply(view.transID, &view.fromAddr, view.type, succ, value, timestamp, coordinator);
+				if (succ) log->logReadSuccess(&memberNode->addr, 0, view.transID, string(view.key), string(value));
+				else log->logReadFail(&memberNode->addr, 0, view.transID, string(view.key));
 				break;
 			}
 			case MessageType::UPDATE:{
-				bool succ = updateKeyValue(msg.key, msg.value, msg.replica);
-				reply(msg.transID, &msg.fromAddr, msg.type, succ, "");
-				if( succ)log->logUpdateSuccess(&memberNode->addr, 0, msg.transID, msg.key,  msg.value);
+				bool succ = updateKeyValue(view.key, Entry(string(view.value), view.timestamp, view.replica, view.coordinator));
+				reply(view.transID, &view.fromAddr, view.type, succ, "");
+				if( succ)log->logUpdateSuccess(&memberNode->addr, 0, view.transID, string(view.key), string(view.value));
 				else 
-					log->logUpdateFail(&memberNode->addr, 0, msg.transID, msg.key,  msg.value);	
+					log->logUpdateFail(&memberNode->addr, 0, view.transID, string(view.key), string(view.value));
 				break;
 			}
 			case MessageType::DELETE:{
-				bool succ = deletekey(msg.key);
-				reply(msg.transID, &msg.fromAddr, msg.type, succ, "");
-				if (succ) log->logDeleteSuccess(&memberNode->addr, 0, msg.transID, msg.key);
-				else log->logDeleteFail(&memberNode->addr, 0,msg.transID, msg.key);
+				bool succ = deletekey(view.key, Entry::tombstone(view.timestamp, view.coordinator));
+				if(view.transID<0){
+					// deletes pushed by other nodes, acknowledged only when hinted
+					if(view.transID <= HINT_TRANSID_BASE)
+						reply(view.transID, &view.fromAddr, view.type, true, "");
+					break;
+				}
+				reply(view.transID, &view.fromAddr, view.type, succ, "");
+				if (succ) log->logDeleteSuccess(&memberNode->addr, 0, view.transID, string(view.key));
+				else log->logDeleteFail(&memberNode->addr, 0, view.transID, string(view.key));
 				break;
 			}
 			case MessageType::READREPLY:{
-				if(!undone.count(msg.transID))break;
-				if(msg.value.size()) 
-					undone[msg.transID]->quorum++;
-				undone[msg.transID]->replies ++;
-				undone[msg.transID]->value = msg.value;
+				auto pending = undone.find(view.transID);
+				auto late = decided.find(view.transID);
+				request *req = pending != undone.end() ? pending->second : late != decided.end() ? late->second : NULL;
+				if(!req)break;
+				// an empty reply is a tombstone, or the key missing if it carries no version
+				if(view.value.size())
+					readRepair(req, &view.fromAddr, Entry(string(view.value), view.timestamp, PRIMARY, view.coordinator));
+				else if(view.timestamp < 0)
+					readRepair(req, &view.fromAddr, Entry("", -1, PRIMARY));
+				else
+					readRepair(req, &view.fromAddr, Entry::tombstone(view.timestamp, view.coordinator));
+				if(pending == undone.end())break;
+				if(view.value.size()) 
+					req->quorum++;
+				req->replies ++;
+				break;
+			}
+			case MessageType::MERKLE:{
+				// the digests and pulls are expanded into the vectors MerkleTree::diff takes
+				Message msg(view);
+				handleMerkle(msg);
 				break;
 			}
 			case MessageType::REPLY:{
-				if(!undone.count(msg.transID))break;
-				if(msg.success)
-					undone[msg.transID]->quorum++;
-				undone[msg.transID]->replies ++;
+				if(view.transID <= HINT_TRANSID_BASE){
+					if(view.success && hints.erase(HINT_TRANSID_BASE - view.transID))
+						hintsDelivered->inc();
+					break;
+				}
+				auto pending = undone.find(view.transID);
+				auto late = decided.find(view.transID);
+				request *req = pending != undone.end() ? pending->second : late != decided.end() ? late->second : NULL;
+				if(!req)break;
+				if(view.success || req->msg_Type == DELETE)
+					req->acked.push_back(view.fromAddr);
+				if(pending == undone.end())break;
+				if(view.success)
+					req->quorum++;
+				req->replies ++;
 
 				break;
 			}
 		}
-		 
+		// the view points into data
+		free(data);
 
 	}
+	// the arena is compacted in the background, a bounded number of slots per tick
+	ht->compactStep(HT_COMPACT_BUDGET);
+	keysStored->set(ht->currentSize());
+	memoryUsed->set(ht->memoryUsage());
+	fragmentation->set((long)(ht->fragmentation() * 100));
 	check_request();
+	deliverHints();
+	expireTombstones();
 	/*
 	 * This function should also ensure all READ and UPDATE operation
 	 * get QUORUM replies
 	 */
 }
 
+/**
+ * FUNCTION NAME: sendMessage
+ *
+ * DESCRIPTION: Serialize the message and send it through EmulNet.
+ * 				Every KV store message goes out through here so it is counted by type and size.
+ *
+ * RETURNS:
+ * bytes handed to the network, 0 if the message was dropped
+ */
+int MP2Node::sendMessage(Address *toAddr, Message &message) {
+	size_t size = message.encode(sendBuffer.data(), sendBuffer.size());
+	int sent = size ? emulNet->ENsend(&memberNode->addr, toAddr, sendBuffer.data(), size) : 0;
+	if ( sent ) {
+		msgsSent[message.type]->inc();
+		bytesSent[message.type]->inc(sent);
+	}
+	return sent;
+}
+
 /**
  * FUNCTION NAME: findNodes
  *
@@ -403,28 +674,45 @@ void MP2Node::checkMessages() {
  * 				This function is responsible for finding the replicas of a key
  */
 vector<Node> MP2Node::findNodes(string key) {
-	size_t pos = hashFunction(key);
+	return findNodes(hashFunction(key), ring, ringIndex);
+}
+
+/**
+ * FUNCTION NAME: findNodes
+ *
+ * DESCRIPTION: The replicas of a ring position, from the index of the ring
+ */
+vector<Node> MP2Node::findNodes(uint64_t pos, vector<Node> &ring, const RingIndex &index) {
 	vector<Node> addr_vec;
-	if (ring.size() >= 3) {
-		// if pos <= min || pos > max, the leader is the min
-		if (pos <= ring.at(0).getHashCode() || pos > ring.at(ring.size()-1).getHashCode()) {
-			addr_vec.emplace_back(ring.at(0));
-			addr_vec.emplace_back(ring.at(1));
-			addr_vec.emplace_back(ring.at(2));
-		}
-		else {
-			// go through the ring until pos <= node
-			for (int i=1; i<ring.size(); i++){
-				Node addr = ring.at(i);
-				if (pos <= addr.getHashCode()) {
-					addr_vec.emplace_back(addr);
-					addr_vec.emplace_back(ring.at((i+1)%ring.size()));
-					addr_vec.emplace_back(ring.at((i+2)%ring.size()));
-					break;
-				}
-			}
-		}
+	const uint32_t *replicas = index.lookup(pos);
+	for (int r = 0; replicas && r < RING_REPLICAS; r++)
+		addr_vec.emplace_back(ring[replicas[r]]);
+	return addr_vec;
+}
+
+/**
+ * FUNCTION NAME: findNodes
+ *
+ * DESCRIPTION: The replicas of a ring position on the given ring: the nodes of the
+ * 				first three tokens clockwise from pos, skipping the other virtual nodes
+ * 				of a node already picked. Empty with fewer than three nodes.
+ * 				Linear in the ring, RingIndex answers the same in O(log n).
+ */
+vector<Node> MP2Node::findNodes(uint64_t pos, vector<Node> &ring) {
+	vector<Node> addr_vec;
+	// if pos <= min || pos > max, the leader is the min
+	size_t i = 0;
+	while (i < ring.size() && pos > ring[i].getHashCode())
+		i++;
+	if (i == ring.size())
+		i = 0;
+	for (size_t k = 0; k < ring.size() && addr_vec.size() < 3; k++){
+		Node &addr = ring[(i + k) % ring.size()];
+		if (!onRing(addr.nodeAddress, addr_vec))
+			addr_vec.emplace_back(addr);
 	}
+	if (addr_vec.size() < 3)
+		addr_vec.clear();
 	return addr_vec;
 }
 /**
@@ -458,31 +746,250 @@ int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
  * 				The function does the following:
  *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
  *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
+ *
+ *				1) Rebalance: the old and new rings are compared segment by segment, a segment
+ *				   being the positions between two consecutive tokens of either ring.
+ *				   A node that gained a segment is sent its keys, once, by the first of
+ *				   the old replicas still on the ring. Only moved keys travel. Skipped when handedOff,
+ *				   the nodes that left already sent their keys to the replicas they gained.
+ *				2) Anti-entropy: for each range between two tokens this node replicates, the digests
+ *				   of the merkle subtrees covering the range go to the replicas that already
+ *				   held all of it, batched per replica. handleMerkle then walks down the subtrees that differ and
+ *				   only the keys of differing buckets are sent. A bucket straddling the end of a
+ *				   range is compared whole, only its keys the peer replicates are sent.
+ *				   When handedOff they also compare with the replicas that gained the range by
+ *				   handoff: it is fire-and-forget, so this round repairs a dropped handoff message.
  */
-void MP2Node::stabilizationProtocol() {
+void MP2Node::stabilizationProtocol(vector<Node> &oldRing, bool handedOff) {
 	/*
 	 * Implement this
 	 */
-	 for(auto [k,v]:this->ht->hashTable){
-	 	stableCreate(k,v);
+	 int n = ring.size();
+	 if(!ringIndex.lookup(0) || !oldRingIndex.lookup(0))
+	 	return;
+
+	 // Step 1: keys whose replica set gained a node.
+	 // Replica sets only change at a token of either ring: segment s is the positions
+	 // after bound s-1 up to bound s, the first one wrapping around the ring.
+	 vector<uint64_t> bounds;
+	 for(Node &node : oldRing)
+	 	bounds.push_back(node.getHashCode());
+	 for(Node &node : ring)
+	 	bounds.push_back(node.getHashCode());
+	 sort(bounds.begin(), bounds.end());
+	 bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+	 size_t segments = bounds.size();
+	 vector<vector<Node>> before(segments);
+	 vector<vector<Address>> targets(segments);
+	 bool moving = false;
+	 for(size_t s = 0; s < segments; s++){
+	 	before[s] = findNodes(bounds[s], oldRing, oldRingIndex);
+	 	Node *sender = NULL;
+	 	for(Node &node : before[s]){
+	 		if(onRing(node.nodeAddress, ring)){
+	 			sender = &node;
+	 			break;
+	 		}
+	 	}
+	 	if(handedOff || !sender || !(sender->nodeAddress == memberNode->addr))
+	 		continue;
+	 	for(Node &node : findNodes(bounds[s], ring, ringIndex)){
+	 		if(!onRing(node.nodeAddress, before[s])){
+	 			targets[s].push_back(node.nodeAddress);
+	 			moving = true;
+	 		}
+	 	}
+	 }
+	 if(moving){
+	 	vector<string_view> keys;
+	 	vector<string_view> values;
+	 	for(auto [k,v]:*this->ht){
+	 		keys.push_back(k);
+	 		values.push_back(v);
+	 	}
+	 	vector<uint64_t> positions(keys.size());
+	 	RingHash::hashBatch(keys.data(), keys.size(), positions.data());
+	 	for(size_t i = 0; i < keys.size(); i++){
+	 		size_t s = lower_bound(bounds.begin(), bounds.end(), positions[i]) - bounds.begin();
+	 		for(Address &to : targets[s == segments ? 0 : s])
+	 			stableCreate(&to, string(keys[i]), Entry(string(values[i])));
+	 	}
+	 }
+
+	 // Step 2: compare with the replicas that kept their ranges
+	 vector<Address> peers;
+	 vector<vector<pair<int, uint64_t>>> digests;
+	 vector<vector<int>> pulls;
+	 for(int j = 0; j < n; j++){
+	 	// keys of range j are the positions after the previous token up to token j itself
+	 	uint64_t prev = ring[(j - 1 + n) % n].getHashCode();
+	 	uint64_t hi = ring[j].getHashCode();
+	 	if(prev == hi)
+	 		continue;
+	 	// the range is made of the segments after the one ending at prev, up to the one ending at hi
+	 	size_t first = (lower_bound(bounds.begin(), bounds.end(), prev) - bounds.begin() + 1) % segments;
+	 	size_t last = lower_bound(bounds.begin(), bounds.end(), hi) - bounds.begin();
+	 	size_t lo = MerkleTree::bucket(prev + 1);
+	 	size_t hiBucket = MerkleTree::bucket(hi);
+	 	// a range wrapping around within one bucket covers all the others
+	 	if(lo == hiBucket && prev + 1 > hi)
+	 		hiBucket = (lo + MERKLE_LEAVES - 1) % MERKLE_LEAVES;
+	 	vector<Node> replicas = findNodes(hi, ring, ringIndex);
+	 	// a node new to part of the range gets it from step 1, or from a handoff it may have missed:
+	 	// only the nodes that kept the range start, by then the handoff reached the others
+	 	if(!onRing(memberNode->addr, replicas) || !keptRange(memberNode->addr, before, first, last))
+	 		continue;
+	 	for(Node &peer : replicas){
+	 		if(peer.nodeAddress == memberNode->addr || !(handedOff || keptRange(peer.nodeAddress, before, first, last)))
+	 			continue;
+	 		size_t k = find(peers.begin(), peers.end(), peer.nodeAddress) - peers.begin();
+	 		if(k == peers.size()){
+	 			peers.push_back(peer.nodeAddress);
+	 			digests.emplace_back();
+	 			pulls.emplace_back();
+	 		}
+	 		tree->rangeDigests(lo, hiBucket, this->par->getcurrtime(), &digests[k], &pulls[k]);
+	 	}
+	 }
+	 for(size_t k = 0; k < peers.size(); k++){
+	 	if(digests[k].size() || pulls[k].size())
+	 		sendMerkle(&peers[k], digests[k], pulls[k]);
 	 }
 	 return;
 }
-void MP2Node::stableCreate(string key, string value) {
+
+/**
+ * FUNCTION NAME: onRing
+ *
+ * DESCRIPTION: Whether the address is one of the nodes
+ */
+bool MP2Node::onRing(Address &address, vector<Node> &nodes) {
+	for(Node &node : nodes){
+		if(node.nodeAddress == address)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: keptRange
+ *
+ * DESCRIPTION: Whether the address replicated every segment of first..last, given the old replicas by segment
+ */
+bool MP2Node::keptRange(Address &address, vector<vector<Node>> &before, size_t first, size_t last) {
+	for(size_t s = first; ; s = (s + 1) % before.size()){
+		if(!onRing(address, before[s]))
+			return false;
+		if(s == last)
+			return true;
+	}
+}
+
+/**
+ * FUNCTION NAME: handleMerkle
+ *
+ * DESCRIPTION: Compare the digests of a peer with the local tree (MerkleTree::diff),
+ * 				push the keys of the buckets the peer lacks or asked for and that it
+ * 				replicates, and answer with the next level of digests and our own pulls.
+ * 				The keys come from bucketKeys, so a message costs the keys it pushes, not the table.
+ */
+void MP2Node::handleMerkle(Message &message) {
+	vector<pair<int, uint64_t>> digests;
+	vector<int> pulls;
+	vector<bool> push(MERKLE_LEAVES, false);
+	tree->diff(message.digests, message.pulls, this->par->getcurrtime(), &digests, &pulls, &push);
+
+	for(size_t b = 0; b < MERKLE_LEAVES; b++){
+		if(!push[b])
+			continue;
+		for(string &key : bucketKeys[b]){
+			string_view value;
+			const uint32_t *replicas = ringIndex.lookup(hashFunction(key));
+			if(!replicas || !this->ht->find(key, &value))
+				continue;
+			for(int r = 0; r < RING_REPLICAS; r++){
+				if(ring[replicas[r]].nodeAddress == message.fromAddr)
+					stableCreate(&message.fromAddr, key, Entry(string(value)));
+			}
+		}
+	}
+	if(digests.size() || pulls.size())
+		sendMerkle(&message.fromAddr, digests, pulls);
+}
+
+/**
+ * FUNCTION NAME: sendMerkle
+ *
+ * DESCRIPTION: Send digests and pulls, split in messages of MERKLE_MAX_ENTRIES
+ */
+void MP2Node::sendMerkle(Address *toAddr, const vector<pair<int, uint64_t>> &digests, const vector<int> &pulls) {
+	size_t d = 0;
+	size_t p = 0;
+	do {
+		size_t dn = min(digests.size() - d, (size_t)MERKLE_MAX_ENTRIES);
+		size_t pn = min(pulls.size() - p, (size_t)MERKLE_MAX_ENTRIES - dn);
+		Message msg(STABILIZATION_TRANSID, this->memberNode->addr,
+				vector<pair<int, uint64_t>>(digests.begin() + d, digests.begin() + d + dn),
+				vector<int>(pulls.begin() + p, pulls.begin() + p + pn));
+		sendMessage(toAddr, msg);
+		d += dn;
+		p += pn;
+	} while(d < digests.size() || p < pulls.size());
+}
+
+/**
+ * FUNCTION NAME: handoff
+ *
+ * DESCRIPTION: Called before this node leaves the group: sends each stored key to the
+ * 				replicas it gains on the ring without this node, so the ring change the
+ * 				others see when the LEAVE arrives needs no stabilization
+ */
+void MP2Node::handoff() {
+	updateRing();
+	vector<Node> inserted;
+	vector<Node> erased;
+	for(int v = 0; v < par->VNODES; v++)
+		erased.emplace_back(memberNode->addr, v);
+	rebuildRing(inserted, erased);
+	if(ring.empty())
+		return;
+	swap(oldRingIndex, ringIndex);
+	ringIndex.build(ring);
+
+	vector<string_view> keys;
+	vector<string_view> values;
+	for(auto [k,v]:*this->ht){
+		keys.push_back(k);
+		values.push_back(v);
+	}
+	vector<uint64_t> positions(keys.size());
+	RingHash::hashBatch(keys.data(), keys.size(), positions.data());
+	for(size_t i = 0; i < keys.size(); i++){
+		vector<Node> before = findNodes(positions[i], oldRing, oldRingIndex);
+		for(Node &node : findNodes(positions[i], ring, ringIndex)){
+			if(!onRing(node.nodeAddress, before))
+				stableCreate(&node.nodeAddress, string(keys[i]), Entry(string(values[i])));
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: stableCreate
+ *
+ * DESCRIPTION: Send one key with its version to a replica, a tombstone as a versioned DELETE.
+ * 				Replicas holding a newer write keep it.
+ */
+void MP2Node::stableCreate(Address *toAddr, const string &key, const Entry &entry) {
 	/*
 	 * Implement this
 	 */
-	 vector<Node>pos=findNodes(key);
-
-	 
-	 for(Node& n:pos){
-		 Message msg (-777,this->memberNode->addr,CREATE,key,value,PRIMARY);
-		 emulNet->ENsend(&memberNode->addr, &n.nodeAddress,  msg.toString());
-	 }
+	 Message msg (STABILIZATION_TRANSID,this->memberNode->addr,entry.deleted ? DELETE : CREATE,key,entry.value,PRIMARY,entry.timestamp,entry.coordinator);
+	 if (sendMessage(toAddr, msg))
+		 stabilizationSent->inc();
 }
 
 
-request::request(int _id, int _timestamp, MessageType _msg_Type, string _key, string _value){
+request::request(int _id, int _timestamp, MessageType _msg_Type, string _key, string _value): newest("", -1, PRIMARY) {
 
 	this->id = _id;
 	this->timestamp = _timestamp;
@@ -493,14 +1000,20 @@ request::request(int _id, int _timestamp, MessageType _msg_Type, string _key, st
 	this->value = _value;
 }
 
-void MP2Node::reply(int transID, Address* fromAddr, MessageType type, bool success, string value){
+hint::hint(Address _target, string _key, const Entry &_entry, int _created, const vector<Address> &_replicas): target(_target), key(_key), entry(_entry), replicas(_replicas) {
+	this->created = _created;
+	// sent on the next delivery pass
+	this->lastSent = _created - HINT_RETRY;
+}
+
+void MP2Node::reply(int transID, Address* fromAddr, MessageType type, bool success, string_view value, int timestamp, int coordinator){
 	if(type != MessageType::READ){
 		Message msg(transID, this->memberNode->addr,  MessageType::REPLY, success);
-		emulNet->ENsend(&memberNode->addr, fromAddr, msg.toString());
+		sendMessage(fromAddr, msg);
 		
 	}else{
-		Message msg(transID, this->memberNode->addr, value);
-		emulNet->ENsend(&memberNode->addr, fromAddr, msg.toString());	
+		Message msg(transID, this->memberNode->addr, string(value), timestamp, coordinator);
+		sendMessage(fromAddr, msg);	
 		
 	}
 	
@@ -508,21 +1021,134 @@ void MP2Node::reply(int transID, Address* fromAddr, MessageType type, bool succe
 
 void MP2Node::check_request(){
 	for(auto p = undone.begin();p!= undone.end();){
-		if(p->second->replies - p->second->quorum >= 2 || this->par->getcurrtime() - p->second->timestamp > 4) {
-			log_fail(p->second);
-			delete p->second;
+		bool failed = p->second->replies - p->second->quorum >= 2 || this->par->getcurrtime() - p->second->timestamp > QUORUM_TIMEOUT;
+		if(failed || p->second->quorum >= 2) {
+			if(failed) {
+				log_fail(p->second);
+				quorumFailure[p->second->msg_Type]->inc();
+			}
+			else {
+				log_succ(p->second);
+				quorumSuccess[p->second->msg_Type]->inc();
+			}
+			requestLatency->observe(this->par->getcurrtime() - p->second->timestamp);
+			decided[p->first] = p->second;
 			p = undone.erase(p);
 			continue;
 		}
-		if(p->second->quorum >= 2) {
-			log_succ(p->second);
+		p++;
+	}	
+	for(auto p = decided.begin();p!= decided.end();){
+		int window = p->second->msg_Type == READ ? READ_REPAIR_WINDOW : QUORUM_TIMEOUT;
+		if(this->par->getcurrtime() - p->second->timestamp > window) {
+			if(p->second->msg_Type != READ)
+				storeHints(p->second);
 			delete p->second;
-			p = undone.erase(p);
+			p = decided.erase(p);
 			continue;
 		}
 		p++;
-	}	
+	}
+	outstandingRequests->set(undone.size());
+}
+/**
+ * FUNCTION NAME: readRepair
+ *
+ * DESCRIPTION: Coordinator side of read repair, called for every READREPLY, including
+ * 				the ones arriving after the READ was decided. A replica without the key
+ * 				answers with timestamp -1, older than any write.
+ * 				The newest entry becomes the value of the READ, and every replica
+ * 				known to hold an older version, or nothing, gets it pushed as a versioned
+ * 				CREATE, or DELETE if the newest entry is a tombstone.
+ */
+void MP2Node::readRepair(request * req, Address * fromAddr, const Entry &entry) {
+	vector<Address> stale;
+	if(entry.newerThan(req->newest)) {
+		// everyone who answered before is behind
+		for(auto &answer : req->answers)
+			stale.push_back(answer.first);
+		req->newest = entry;
+		req->value = entry.value;
+	}
+	else if(req->newest.newerThan(entry)) {
+		stale.push_back(*fromAddr);
+	}
+	req->answers.emplace_back(*fromAddr, entry);
+
+	for(Address &addr : stale) {
+		Message msg(READ_REPAIR_TRANSID, this->memberNode->addr, req->newest.deleted ? DELETE : CREATE, req->key, req->newest.value, PRIMARY, req->newest.timestamp, req->newest.coordinator);
+		if(sendMessage(&addr, msg))
+			readRepairsSent->inc();
+	}
 }
+
+/**
+ * FUNCTION NAME: storeHints
+ *
+ * DESCRIPTION: Coordinator side of hinted handoff, called QUORUM_TIMEOUT ticks after a
+ * 				write, whether it reached quorum or not, so a replica that was down is still
+ * 				caught up. Every replica that did not acknowledge it by then gets a hint with
+ * 				the version the write was issued with, a delete its tombstone.
+ * 				An UPDATE no replica applied was refused for a missing key and is not hinted.
+ */
+void MP2Node::storeHints(request * req) {
+	if(req->msg_Type == UPDATE && req->acked.empty())
+		return;
+	Entry entry = req->msg_Type == DELETE ? Entry::tombstone(req->timestamp, coordinatorId) : Entry(req->value, req->timestamp, PRIMARY, coordinatorId);
+	for(Address &addr : req->replicas) {
+		if(find(req->acked.begin(), req->acked.end(), addr) != req->acked.end())
+			continue;
+		hints.emplace(nextHint++, hint(addr, req->key, entry, req->timestamp, req->replicas));
+		hintsStored->inc();
+	}
+}
+
+/**
+ * FUNCTION NAME: deliverHints
+ *
+ * DESCRIPTION: Sends each hint to its target as a versioned CREATE (DELETE for a tombstone)
+ * 				every HINT_RETRY ticks, until the target acknowledges it. Once membership has
+ * 				removed the target, the hint goes to the node that took its place among the
+ * 				replicas of the key instead (sloppy quorum), so the write does not wait for a
+ * 				stabilization pass to reach it. The other replicas acknowledged the write or
+ * 				have hints of their own.
+ */
+void MP2Node::deliverHints() {
+	int now = this->par->getcurrtime();
+	vector<hint> forwarded;
+	for(auto p = hints.begin(); p != hints.end();) {
+		hint &h = p->second;
+		if(now - h.created > HINT_TTL) {
+			hintsDropped->inc();
+			p = hints.erase(p);
+			continue;
+		}
+		if(!onRing(h.target, ring)) {
+			for(Node &n : findNodes(h.key)) {
+				if(find(h.replicas.begin(), h.replicas.end(), n.nodeAddress) != h.replicas.end())
+					continue;
+				if(n.nodeAddress == this->memberNode->addr)
+					storeEntry(h.key, h.entry, false);
+				else
+					forwarded.emplace_back(n.nodeAddress, h.key, h.entry, h.created, h.replicas);
+			}
+			p = hints.erase(p);
+			continue;
+		}
+		if(now - h.lastSent >= HINT_RETRY) {
+			Message msg(HINT_TRANSID_BASE - p->first, this->memberNode->addr, h.entry.deleted ? DELETE : CREATE, h.key, h.entry.value, PRIMARY, h.entry.timestamp, h.entry.coordinator);
+			sendMessage(&h.target, msg);
+			h.lastSent = now;
+		}
+		p++;
+	}
+	for(hint &h : forwarded) {
+		hints.emplace(nextHint++, h);
+		hintsStored->inc();
+	}
+	hintsPending->set(hints.size());
+}
+
 void MP2Node::log_fail(request * req) {
 	switch (req->msg_Type) {
 		case CREATE:
@@ -537,6 +1163,9 @@ void MP2Node::log_fail(request * req) {
 		case DELETE: 
 			log->logDeleteFail(&memberNode->addr, 1, req->id, req->key);
 			break;
+		default:
+			// REPLY, READREPLY and MERKLE are never client requests
+			break;
 	}
 }
 void MP2Node::log_succ(request * req) {
@@ -552,5 +1181,9 @@ void MP2Node::log_succ(request * req) {
 			break;
 		case DELETE: 
 			log->logDeleteSuccess(&memberNode->addr, 1, req->id, req->key);
+			break;
+		default:
+			// REPLY, READREPLY and MERKLE are never client requests
+			break;
 	}
 }
@@ -18,6 +18,32 @@
 #include "Params.h"
 #include "Message.h"
 #include "Queue.h"
+#include "Metrics.h"
+#include "MerkleTree.h"
+#include "RingIndex.h"
+
+/**
+ * Macros
+ */
+// transID of the writes pushed to stale replicas, negative so they are neither logged nor acknowledged
+#define READ_REPAIR_TRANSID -778
+// ticks after a READ was issued during which late replies still trigger read repair
+#define READ_REPAIR_WINDOW 10
+// transID of the keys pushed by anti-entropy, negative so they are neither logged nor acknowledged
+#define STABILIZATION_TRANSID -777
+// digests and pulls in one MERKLE message, keeps it under MAX_MSG_SIZE
+#define MERKLE_MAX_ENTRIES 64
+// ticks a client request waits for its quorum
+#define QUORUM_TIMEOUT 4
+// transID of a hinted write is HINT_TRANSID_BASE - hint id, negative so it is not logged, but acknowledged
+#define HINT_TRANSID_BASE -1000
+// ticks between two deliveries of the same hint
+#define HINT_RETRY 5
+// ticks after which a hint that could not be delivered is dropped
+#define HINT_TTL 100
+// ticks a delete is kept as a tombstone, past the last hint and read repair that could carry the
+// older value (anti-entropy rounds finish a few ticks after the ring change that starts them)
+#define TOMBSTONE_TTL (HINT_TTL + READ_REPAIR_WINDOW)
 
 /**
  * CLASS NAME: MP2Node
@@ -39,18 +65,57 @@ public:
 	string key;
 	string value;
 	MessageType msg_Type;
+	// READ: newest entry among the replies and what each replica answered
+	Entry newest;
+	vector<pair<Address, Entry>> answers;
+	// CREATE/UPDATE/DELETE: replicas the write was sent to and the ones that applied it,
+	// which for a DELETE is any that answered: a replica stores the tombstone either way
+	vector<Address> replicas;
+	vector<Address> acked;
 
 };
-class MP2Node {
+/**
+ * CLASS NAME: hint
+ *
+ * DESCRIPTION: A write a replica did not acknowledge, kept by the coordinator
+ * 				and delivered again until the replica acknowledges it. A delete is
+ * 				delivered as its tombstone.
+ */
+class hint {
+public:
+	hint(Address _target, string _key, const Entry &_entry, int _created, const vector<Address> &_replicas);
+	Address target;
+	string key;
+	Entry entry;
+	// replicas the write was sent to, the target among them
+	vector<Address> replicas;
+	int created;
+	int lastSent;
+};
+class MP2Node : public MembershipListener {
 private:
 	// Vector holding the next two neighbors in the ring who have my replicas
 	vector<Node> hasMyReplicas;
 	// Vector holding the previous two neighbors in the ring whose replicas I have
 	vector<Node> haveReplicasOf;
-	// Ring
+	// Ring, and the ring before the last rebuildRing, the stabilization protocol compares them
 	vector<Node> ring;
+	vector<Node> oldRing;
+	// Replica lookup over ring, and over the ring before the last change
+	RingIndex ringIndex;
+	RingIndex oldRingIndex;
+	// membership epoch the ring reflects, -1 before the first updateRing
+	long ringEpoch;
+	// membership changes MP1Node delivered and the ring does not reflect yet, and the
+	// membership epoch after them
+	vector<MembershipEvent> changes;
+	long membershipEpoch;
 	// Hash Table
 	HashTable * ht;
+	// Hash tree over ht by ring position, compared with the other replicas after a ring change
+	MerkleTree * tree;
+	// keys of ht by merkle bucket, so anti-entropy only reads the keys of the buckets it pushes
+	vector<vector<string>> bucketKeys;
 	// Member representing this member
 	Member *memberNode;
 	// Params object
@@ -59,19 +124,63 @@ private:
 	EmulNet * emulNet;
 	// Object of Log
 	Log * log;
+	// Metrics registry
+	Metrics * metrics;
+	// id of this node, the coordinator part of the versions it issues
+	int coordinatorId;
 	
 	map<int, request*> undone;
+	// requests already decided and still waiting for late replies: READs for READ_REPAIR_WINDOW
+	// ticks, writes for QUORUM_TIMEOUT ticks
+	map<int, request*> decided;
+	// hinted handoff: writes to deliver to the replicas that missed them, by hint id
+	map<int, hint> hints;
+	int nextHint;
+	// (time written, key) of the tombstones in ht, oldest first
+	queue<pair<int, string>> tombstones;
+	// messages the stabilization protocol sent for ring changes that removed a node, by the
+	// removed node's address, until it joins again
+	map<string, long> removals;
+	// encoding buffer of sendMessage, MAX_MSG_SIZE bytes
+	vector<char> sendBuffer;
+
+	// Metric handles, indexed by MessageType where it applies
+	Counter * msgsSent[MERKLE + 1];
+	Counter * bytesSent[MERKLE + 1];
+	Counter * quorumSuccess[DELETE + 1];
+	Counter * quorumFailure[DELETE + 1];
+	Counter * stabilizationSent;
+	Counter * readRepairsSent;
+	Counter * hintsStored;
+	Counter * hintsDelivered;
+	Counter * hintsDropped;
+	Counter * malformedMessages;
+	Counter * falseRemovalMessages;
+	Gauge * hintsPending;
+	Gauge * ringSize;
+	Gauge * ownership;
+	Gauge * keysStored;
+	Gauge * outstandingRequests;
+	Gauge * memoryUsed;
+	Gauge * fragmentation;
+	Histogram * requestLatency;
 
 public:
-	MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember);
+	MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Metrics *metrics, Address *addressOfMember);
 	Member * getMemberNode() {
 		return this->memberNode;
 	}
 
+	// membership changes from MP1Node, applied to the ring by updateRing
+	void onJoin(Address &addr);
+	void onLeave(Address &addr, bool left);
+	void onEpoch(long epoch);
+
 	// ring functionalities
 	void updateRing();
+	bool rebuildRing(vector<Node> &inserted, vector<Node> &erased);
 	vector<Node> getMembershipList();
-	size_t hashFunction(string key);
+	static uint64_t hashFunction(const string &key);
 	void findNeighbors();
 
 	// client side CRUD APIs
@@ -89,19 +198,34 @@ public:
 
 	// coordinator dispatches messages to corresponding nodes
 	void dispatchMessages(Message message);
+	// serialize and send one message, accounting for it in the metrics
+	int sendMessage(Address *toAddr, Message &message);
 
 	// find the addresses of nodes that are responsible for a key
 	vector<Node> findNodes(string key);
+	static vector<Node> findNodes(uint64_t pos, vector<Node> &ring);
+	static vector<Node> findNodes(uint64_t pos, vector<Node> &ring, const RingIndex &index);
+	static bool onRing(Address &address, vector<Node> &nodes);
+	static bool keptRange(Address &address, vector<vector<Node>> &before, size_t first, size_t last);
 
 	// server
-	bool createKeyValue(string key, string value, ReplicaType replica);
-	string readKey(string key);
-	bool updateKeyValue(string key, string value, ReplicaType replica);
-	bool deletekey(string key);
-	void stableCreate(string key, string value);
+	bool createKeyValue(string_view key, const Entry &entry);
+	bool readKey(string_view key, string_view *value);
+	bool updateKeyValue(string_view key, const Entry &entry);
+	bool deletekey(string_view key, const Entry &tombstone);
+	bool storeEntry(string_view key, const Entry &entry, bool onlyLive);
+	void expireTombstones();
+	void stableCreate(Address *toAddr, const string &key, const Entry &entry);
 	// stabilization protocol - handle multiple failures
-	void stabilizationProtocol();
-	void reply(int transID, Address* fromAddr, MessageType type, bool success, string value);
+	void stabilizationProtocol(vector<Node> &oldRing, bool handedOff);
+	// graceful leave - hand the keys off to their next owners
+	void handoff();
+	void handleMerkle(Message &message);
+	void sendMerkle(Address *toAddr, const vector<pair<int, uint64_t>> &digests, const vector<int> &pulls);
+	void reply(int transID, Address* fromAddr, MessageType type, bool success, string_view value, int timestamp = 0, int coordinator = 0);
+	void readRepair(request * req, Address * fromAddr, const Entry &entry);
+	void storeHints(request * req);
+	void deliverHints();
 	void log_succ(request * req);
 	void log_fail(request * req);
 	void check_request();
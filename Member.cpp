@@ -139,6 +139,195 @@ void MemberListEntry::settimestamp(long timestamp) {
 	this->timestamp = timestamp;
 }
 
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Record an inter-arrival time, replacing the oldest once the window is full
+ */
+void ArrivalWindow::add(long interval) {
+	unsigned char value = (unsigned char)min(interval, (long)UCHAR_MAX);
+	if ( count == PHI_WINDOW ) {
+		sum -= intervals[next];
+		squares -= intervals[next] * intervals[next];
+	}
+	else {
+		count++;
+	}
+	intervals[next] = value;
+	next = (next + 1) % PHI_WINDOW;
+	sum += value;
+	squares += value * value;
+}
+
+/**
+ * FUNCTION NAME: phi
+ *
+ * DESCRIPTION: Suspicion level of a member last heard from elapsed ticks ago:
+ * 				-log10 of the probability that a heartbeat arrives that late, the
+ * 				inter-arrival times being taken as normal. The normal CDF is the
+ * 				logistic approximation of Bowling et al. Needs a non-empty window.
+ */
+double ArrivalWindow::phi(long elapsed) const {
+	double mean = (double)sum / count;
+	double stddev = max(PHI_MIN_STDDEV, sqrt(max(0.0, (double)squares / count - mean * mean)));
+	double y = (elapsed - mean) / stddev;
+	double e = exp(-y * (1.5976 + 0.070566 * y * y));
+	return elapsed > mean ? -log10(e / (1.0 + e)) : -log10(1.0 - 1.0 / (1.0 + e));
+}
+
+/**
+ * Constructor
+ */
+MemberTable::MemberTable() {
+	rehash(MEMBER_TABLE_MIN_SLOTS);
+}
+
+/**
+ * FUNCTION NAME: home
+ *
+ * DESCRIPTION: Slot an (id, port) hashes to, by Fibonacci hashing
+ */
+size_t MemberTable::home(int id, short port) const {
+	uint64_t key = ((uint64_t)(uint32_t)id << 16) | (unsigned short)port;
+	return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+ * FUNCTION NAME: slot
+ *
+ * DESCRIPTION: Slot holding (id, port), or the free slot where it would go
+ */
+size_t MemberTable::slot(int id, short port) const {
+	size_t mask = slots.size() - 1;
+	size_t i = home(id, port);
+	while ( slots[i] >= 0 && (ids[slots[i]] != id || ports[slots[i]] != port) ) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+/**
+ * FUNCTION NAME: rehash
+ *
+ * DESCRIPTION: Rebuild the index with the given number of slots, a power of two
+ */
+void MemberTable::rehash(size_t capacity) {
+	slots.assign(capacity, -1);
+	shift = 64;
+	for ( size_t c = capacity; c > 1; c >>= 1 ) {
+		shift--;
+	}
+	for ( size_t row = 0; row < ids.size(); row++ ) {
+		slots[slot(ids[row], ports[row])] = row;
+	}
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Row of a member, -1 if it is not in the table
+ */
+int MemberTable::find(int id, short port) const {
+	return slots[slot(id, port)];
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Append a member that is not in the table yet
+ *
+ * RETURNS:
+ * its row
+ */
+size_t MemberTable::add(int id, short port, long heartbeat, long timestamp) {
+	if ( 2 * (ids.size() + 1) > slots.size() ) {
+		rehash(2 * slots.size());
+	}
+	size_t row = ids.size();
+	slots[slot(id, port)] = row;
+	ids.push_back(id);
+	ports.push_back(port);
+	heartbeats.push_back(heartbeat);
+	timestamps.push_back(timestamp);
+	addrs.push_back(Address::fromIdPort(id, port));
+	arrivals.emplace_back();
+	return row;
+}
+
+/**
+ * FUNCTION NAME: remove
+ *
+ * DESCRIPTION: Remove a row, moving the last row into it. The entries after the freed
+ * 				slot shift back into it when that brings them closer to their home slot,
+ * 				so lookups never need tombstones.
+ */
+void MemberTable::remove(size_t row) {
+	size_t mask = slots.size() - 1;
+	size_t hole = slot(ids[row], ports[row]);
+	for ( size_t i = (hole + 1) & mask; slots[i] >= 0; i = (i + 1) & mask ) {
+		size_t h = home(ids[slots[i]], ports[slots[i]]);
+		if ( ((i - h) & mask) >= ((i - hole) & mask) ) {
+			slots[hole] = slots[i];
+			hole = i;
+		}
+	}
+	slots[hole] = -1;
+
+	size_t last = ids.size() - 1;
+	if ( row != last ) {
+		slots[slot(ids[last], ports[last])] = row;
+		ids[row] = ids[last];
+		ports[row] = ports[last];
+		heartbeats[row] = heartbeats[last];
+		timestamps[row] = timestamps[last];
+		addrs[row] = addrs[last];
+		arrivals[row] = arrivals[last];
+	}
+	ids.pop_back();
+	ports.pop_back();
+	heartbeats.pop_back();
+	timestamps.pop_back();
+	addrs.pop_back();
+	arrivals.pop_back();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every member
+ */
+void MemberTable::clear() {
+	ids.clear();
+	ports.clear();
+	heartbeats.clear();
+	timestamps.clear();
+	addrs.clear();
+	arrivals.clear();
+	rehash(MEMBER_TABLE_MIN_SLOTS);
+}
+
+/**
+ * FUNCTION NAME: entry
+ *
+ * DESCRIPTION: A row as a MemberListEntry
+ */
+MemberListEntry MemberTable::entry(size_t row) const {
+	return MemberListEntry(ids[row], ports[row], heartbeats[row], timestamps[row]);
+}
+
+/**
+ * FUNCTION NAME: view
+ *
+ * DESCRIPTION: Copy the table into a membership list
+ */
+void MemberTable::view(vector<MemberListEntry> &list) const {
+	list.clear();
+	list.reserve(ids.size());
+	for ( size_t row = 0; row < ids.size(); row++ ) {
+		list.emplace_back(ids[row], ports[row], heartbeats[row], timestamps[row]);
+	}
+}
+
 /**
  * Copy Constructor
  */
@@ -151,8 +340,10 @@ Member::Member(const Member &anotherMember) {
 	this->heartbeat = anotherMember.heartbeat;
 	this->pingCounter = anotherMember.pingCounter;
 	this->timeOutCounter = anotherMember.timeOutCounter;
+	this->members = anotherMember.members;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
+	this->epoch = anotherMember.epoch;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 }
@@ -169,8 +360,10 @@ Member& Member::operator =(const Member& anotherMember) {
 	this->heartbeat = anotherMember.heartbeat;
 	this->pingCounter = anotherMember.pingCounter;
 	this->timeOutCounter = anotherMember.timeOutCounter;
+	this->members = anotherMember.members;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
+	this->epoch = anotherMember.epoch;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 	return *this;
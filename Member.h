@@ -9,6 +9,17 @@
 
 #include "stdincludes.h"
 
+/*
+ * Macros
+ */
+// index slots of an empty MemberTable
+#define MEMBER_TABLE_MIN_SLOTS 16
+// heartbeat inter-arrival times kept per member for phi-accrual failure detection
+#define PHI_WINDOW 16
+// floor of the inter-arrival standard deviation, in ticks, so a member heard from every
+// tick is not removed the first tick it is late
+#define PHI_MIN_STDDEV 1.0
+
 /**
  * CLASS NAME: q_elt
  *
@@ -30,6 +41,11 @@ class Address {
 public:
 	char addr[6];
 	Address() {}
+	// Address of node id:port, byte by byte in the layout the memcpy of id and port
+	// gives on the little-endian hosts this runs on
+	static constexpr Address fromIdPort(int id, short port) {
+		return Address(id, port);
+	}
 	// Copy constructor
 	Address(const Address &anotherAddress);
 	 // Overloaded = operator
@@ -52,6 +68,14 @@ public:
 	void init() {
 		memset(&addr, 0, sizeof(addr));
 	}
+	constexpr int getId() const {
+		return (int)((unsigned char)addr[0] | (unsigned char)addr[1] << 8 | (unsigned char)addr[2] << 16 | (unsigned)(unsigned char)addr[3] << 24);
+	}
+	constexpr short getPort() const {
+		return (short)((unsigned char)addr[4] | (unsigned char)addr[5] << 8);
+	}
+private:
+	constexpr Address(int id, short port): addr{(char)id, (char)(id >> 8), (char)(id >> 16), (char)(id >> 24), (char)port, (char)(port >> 8)} {}
 };
 
 /**
@@ -80,6 +104,99 @@ public:
 	void settimestamp(long timestamp);
 };
 
+/**
+ * STRUCT NAME: ArrivalWindow
+ *
+ * DESCRIPTION: The last PHI_WINDOW inter-arrival times of a member's heartbeats, in ticks
+ * 				capped at UCHAR_MAX, with their running sum and sum of squares
+ */
+struct ArrivalWindow {
+	unsigned char intervals[PHI_WINDOW];
+	unsigned char count;
+	unsigned char next;
+	int sum;
+	int squares;
+	ArrivalWindow(): count(0), next(0), sum(0), squares(0) {}
+	void add(long interval);
+	double phi(long elapsed) const;
+};
+
+/**
+ * CLASS NAME: MemberTable
+ *
+ * DESCRIPTION: Membership table of a node in struct-of-arrays form, one row per member,
+ * 				so a pass over the heartbeats or the timestamps walks one contiguous array.
+ * 				A row is found by (id, port) through an open addressing index with linear
+ * 				probing. Removing a row moves the last row into it.
+ */
+class MemberTable {
+public:
+	vector<int> ids;
+	vector<short> ports;
+	vector<long> heartbeats;
+	vector<long> timestamps;
+	// each member's Address, built once when it is added
+	vector<Address> addrs;
+	vector<ArrivalWindow> arrivals;
+	MemberTable();
+	size_t size() const { return ids.size(); }
+	int find(int id, short port) const;
+	size_t add(int id, short port, long heartbeat, long timestamp);
+	void remove(size_t row);
+	void clear();
+	MemberListEntry entry(size_t row) const;
+	void view(vector<MemberListEntry> &list) const;
+private:
+	// row of each (id, port), -1 for a free slot; a power of two kept at most half full
+	vector<int> slots;
+	int shift;
+	size_t home(int id, short port) const;
+	size_t slot(int id, short port) const;
+	void rehash(size_t capacity);
+};
+
+/**
+ * Kinds of membership change
+ */
+enum MembershipChange {
+	MEMBER_JOINED,
+	// suspected by SWIM, still a member
+	MEMBER_SUSPECTED,
+	// removed by the failure detector
+	MEMBER_FAILED,
+	// removed after a LEAVE, the node handed its keys off before going
+	MEMBER_LEFT
+};
+
+/**
+ * STRUCT NAME: MembershipEvent
+ *
+ * DESCRIPTION: A change of the membership list and the epoch it started. A suspicion does
+ * 				not start an epoch.
+ */
+struct MembershipEvent {
+	Address addr;
+	MembershipChange change;
+	long epoch;
+};
+
+/**
+ * CLASS NAME: MembershipListener
+ *
+ * DESCRIPTION: Subscriber to the membership changes of an MP1Node. They come in one batch at
+ * 				the end of each tick that had some: a call per change in order, then onEpoch
+ * 				with the membership epoch after them. Ticks without a change cost nothing.
+ */
+class MembershipListener {
+public:
+	virtual void onJoin(Address &addr) {}
+	// left: the node sent a LEAVE, else the failure detector removed it
+	virtual void onLeave(Address &addr, bool left) {}
+	virtual void onSuspect(Address &addr) {}
+	virtual void onEpoch(long epoch) {}
+	virtual ~MembershipListener() {}
+};
+
 /**
  * CLASS NAME: Member
  *
@@ -105,9 +222,13 @@ public:
 	// counter for ping timeout
 	int timeOutCounter;
 	// Membership table
+	MemberTable members;
+	// Copy of the membership table, refreshed when the epoch moves
 	vector<MemberListEntry> memberList;
 	// My position in the membership table
 	vector<MemberListEntry>::iterator myPos;
+	// Membership epoch, bumped by MP1Node at each join and removal
+	long epoch;
 	// Queue for failure detection messages
 	queue<q_elt> mp1q;
 	// Queue for KVstore messages
@@ -115,7 +236,7 @@ public:
 	/**
 	 * Constructor
 	 */
-	Member(): inited(false), inGroup(false), bFailed(false), nnb(0), heartbeat(0), pingCounter(0), timeOutCounter(0) {}
+	Member(): inited(false), inGroup(false), bFailed(false), nnb(0), heartbeat(0), pingCounter(0), timeOutCounter(0), epoch(0) {}
 	// copy constructor
 	Member(const Member &anotherMember);
 	// Assignment operator overloading
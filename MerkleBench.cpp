@@ -0,0 +1,282 @@
+/**********************************
+ * FILE NAME: MerkleBench.cpp
+ *
+ * DESCRIPTION: Messages and bytes MP2Node::stabilizationProtocol and handleMerkle send
+ * 				after one ring change: a node fails, a node leaves after handing its
+ * 				keys off (GRACEFUL_LEAVE), or a node joins. MP2Nodes run over EmulNet as
+ * 				in Application::mp2Run, with the membership changes delivered to them
+ * 				directly instead of by MP1Node. Every replica starts with its keys. Key
+ * 				messages are the stabilization CREATE/DELETEs, digest messages the
+ * 				MERKLE ones, the handoff of a leave included. Needed is the replicas the
+ * 				change left without their key, which any protocol has to send (none for
+ * 				a leave, whose handoff arrived first); missing is those still without it
+ * 				once the network is quiet.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./MerkleBench [keys per node, default 2000] [nodes, default 10]
+ **********************************/
+
+#include "MP2Node.h"
+
+/*
+ * Macros
+ */
+// ticks without a message sent after which the exchange is over
+#define QUIET_TICKS 3
+// ticks an exchange is given to finish
+#define EXCHANGE_LIMIT 100
+
+/**
+ * What the benchmark does to the ring
+ */
+enum RingChange {
+	NODE_FAILS,
+	NODE_LEAVES,
+	NODE_JOINS
+};
+
+/**
+ * STRUCT NAME: Result
+ *
+ * DESCRIPTION: Traffic and repair of one ring change
+ */
+struct Result {
+	long needed;
+	long keyMessages;
+	long keyBytes;
+	long merkleMessages;
+	long merkleBytes;
+	long missing;
+	// -1 if messages were still sent after EXCHANGE_LIMIT ticks
+	int ticks;
+};
+
+/**
+ * STRUCT NAME: Cluster
+ *
+ * DESCRIPTION: MP2Nodes on one EmulNet, the last one off the ring until it joins
+ */
+struct Cluster {
+	Params *par;
+	Log *log;
+	Metrics *metrics;
+	EmulNet *en;
+	vector<MP2Node *> nodes;
+	long epoch;
+};
+
+/**
+ * FUNCTION NAME: sent
+ *
+ * DESCRIPTION: Messages and bytes sent so far of the given types
+ */
+static pair<long, long> sent(Metrics *metrics, vector<const char *> types) {
+	pair<long, long> total(0, 0);
+	for ( const char *type : types ) {
+		total.first += metrics->counter("messages_sent_total", "", Metrics::label("type", type))->get();
+		total.second += metrics->counter("message_bytes_sent_total", "", Metrics::label("type", type))->get();
+	}
+	return total;
+}
+
+/**
+ * FUNCTION NAME: changeRing
+ *
+ * DESCRIPTION: What MP1Node reports to the MP2Node of every live node on the ring for a join or
+ * 				a removal, then the updateRing of Application::mp2Run, which starts the
+ * 				stabilization protocol
+ */
+static void changeRing(Cluster &cluster, Address &addr, bool joined, bool left) {
+	cluster.epoch++;
+	for ( MP2Node *node : cluster.nodes ) {
+		Member *member = node->getMemberNode();
+		if ( member->bFailed || !member->inGroup ) {
+			continue;
+		}
+		if ( joined ) {
+			node->onJoin(addr);
+		}
+		else {
+			node->onLeave(addr, left);
+		}
+		node->onEpoch(cluster.epoch);
+	}
+	for ( MP2Node *node : cluster.nodes ) {
+		if ( !node->getMemberNode()->bFailed && node->getMemberNode()->inGroup ) {
+			node->updateRing();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: deliver
+ *
+ * DESCRIPTION: Receive and handle the messages of one tick, as Application::mp2Run
+ */
+static void deliver(Cluster &cluster) {
+	for ( MP2Node *node : cluster.nodes ) {
+		node->recvLoop();
+	}
+	for ( int i = cluster.nodes.size() - 1; i >= 0; i-- ) {
+		Member *member = cluster.nodes[i]->getMemberNode();
+		if ( !member->bFailed && member->inGroup ) {
+			cluster.nodes[i]->checkMessages();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: underReplicated
+ *
+ * DESCRIPTION: Replicas on the ring of the observer that do not store their key
+ */
+static long underReplicated(Cluster &cluster, MP2Node *observer, vector<string> &keys) {
+	long count = 0;
+	string_view value;
+	for ( string &key : keys ) {
+		for ( Node &replica : observer->findNodes(key) ) {
+			int id;
+			memcpy(&id, &replica.nodeAddress.addr[0], sizeof(int));
+			count += !cluster.nodes[id - 1]->readKey(key, &value);
+		}
+	}
+	return count;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Build a ring of n nodes with VNODES tokens each, store the keys on their
+ * 				replicas, apply the change and run Application::mp2Run until no message is sent
+ */
+static Result run(int n, int vnodes, vector<string> &keys, RingChange change) {
+	Cluster cluster;
+	cluster.par = new Params();
+	Params *par = cluster.par;
+	par->EN_GPSZ = n + 1;
+	par->MAX_NNB = n + 1;
+	par->STEP_RATE = 0;
+	par->MAX_MSG_SIZE = 4000;
+	par->globaltime = 0;
+	par->dropmsg = 0;
+	par->PORTNUM = 0;
+	par->VNODES = vnodes;
+	cluster.log = new Log(par);
+	cluster.metrics = new Metrics(par);
+	cluster.en = new EmulNet(par);
+	cluster.epoch = 0;
+	for ( int i = 0; i <= n; i++ ) {
+		Address address;
+		cluster.en->ENinit(&address, par->PORTNUM);
+		Member *member = new Member;
+		member->inited = true;
+		member->inGroup = i < n;
+		cluster.nodes.push_back(new MP2Node(member, par, cluster.en, cluster.log, cluster.metrics, &address));
+	}
+	// the first ring has nothing to stabilize
+	cluster.epoch++;
+	for ( int i = 0; i < n; i++ ) {
+		for ( int j = 0; j < n; j++ ) {
+			cluster.nodes[i]->onJoin(cluster.nodes[j]->getMemberNode()->addr);
+		}
+		cluster.nodes[i]->onEpoch(cluster.epoch);
+		cluster.nodes[i]->updateRing();
+	}
+	MP2Node *observer = cluster.nodes[0];
+	for ( string &key : keys ) {
+		for ( Node &replica : observer->findNodes(key) ) {
+			int id;
+			memcpy(&id, &replica.nodeAddress.addr[0], sizeof(int));
+			cluster.nodes[id - 1]->createKeyValue(key, Entry("value" + key, 1, PRIMARY, 1));
+		}
+	}
+
+	// the node in the middle of the ring fails or leaves, or the spare node joins
+	pair<long, long> keysBefore = sent(cluster.metrics, {"CREATE", "DELETE"});
+	pair<long, long> merkleBefore = sent(cluster.metrics, {"MERKLE"});
+	MP2Node *changed = cluster.nodes[NODE_JOINS == change ? n : n / 2];
+	Member *member = changed->getMemberNode();
+	if ( NODE_JOINS == change ) {
+		member->inGroup = true;
+		for ( int i = 0; i < n; i++ ) {
+			changed->onJoin(cluster.nodes[i]->getMemberNode()->addr);
+		}
+		changeRing(cluster, member->addr, true, false);
+	}
+	else {
+		if ( NODE_LEAVES == change ) {
+			changed->handoff();
+		}
+		member->bFailed = true;
+		if ( NODE_LEAVES == change ) {
+			// the LEAVE reaches the others a tick after the handoff, as with MP1Node
+			deliver(cluster);
+		}
+		changeRing(cluster, member->addr, false, NODE_LEAVES == change);
+	}
+
+	Result result;
+	result.needed = underReplicated(cluster, observer, keys);
+	result.ticks = -1;
+	long lastSent = -1;
+	int quiet = 0;
+	for ( par->globaltime = 1; par->globaltime <= EXCHANGE_LIMIT; par->globaltime++ ) {
+		deliver(cluster);
+		long total = sent(cluster.metrics, {"CREATE", "DELETE", "MERKLE"}).first;
+		quiet = total == lastSent ? quiet + 1 : 0;
+		lastSent = total;
+		if ( QUIET_TICKS == quiet ) {
+			result.ticks = par->globaltime - QUIET_TICKS;
+			break;
+		}
+	}
+	pair<long, long> keysAfter = sent(cluster.metrics, {"CREATE", "DELETE"});
+	pair<long, long> merkleAfter = sent(cluster.metrics, {"MERKLE"});
+	result.keyMessages = keysAfter.first - keysBefore.first;
+	result.keyBytes = keysAfter.second - keysBefore.second;
+	result.merkleMessages = merkleAfter.first - merkleBefore.first;
+	result.merkleBytes = merkleAfter.second - merkleBefore.second;
+	result.missing = underReplicated(cluster, observer, keys);
+
+	for ( MP2Node *node : cluster.nodes ) {
+		delete node;
+	}
+	cluster.en->ENcleanup();
+	delete cluster.en;
+	delete cluster.metrics;
+	delete cluster.log;
+	delete par;
+	return result;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	size_t keysPerNode = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+	int n = argc > 2 ? min(atoi(argv[2]), MAX_NODES - 1) : 10;
+	// every key has three replicas
+	vector<string> keys;
+	for ( size_t i = 0; i < keysPerNode * n / 3; i++ ) {
+		keys.push_back("key" + to_string(i));
+	}
+
+	printf("%d nodes, %zu keys, %zu per node\n", n, keys.size(), keysPerNode);
+	printf("%6s %8s %8s %10s %12s %10s %12s %8s %6s\n", "vnodes", "change", "needed", "key msgs", "key bytes",
+			"merkle msgs", "merkle bytes", "missing", "ticks");
+	const char *names[] = {"fail", "leave", "join"};
+	long missing = 0;
+	for ( int vnodes : {1, 8, 64} ) {
+		for ( RingChange change : {NODE_FAILS, NODE_LEAVES, NODE_JOINS} ) {
+			Result result = run(n, vnodes, keys, change);
+			printf("%6d %8s %8ld %10ld %12ld %10ld %12ld %8ld %6d\n", vnodes, names[change], result.needed,
+					result.keyMessages, result.keyBytes, result.merkleMessages, result.merkleBytes, result.missing,
+					result.ticks);
+			missing += result.missing;
+		}
+	}
+	return missing ? FAILURE : SUCCESS;
+}
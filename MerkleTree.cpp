@@ -0,0 +1,169 @@
+/**********************************
+ * FILE NAME: MerkleTree.cpp
+ *
+ * DESCRIPTION: Definition of the MerkleTree class
+ **********************************/
+
+#include "MerkleTree.h"
+#include "RingHash.h"
+
+static_assert(MERKLE_BITS > 0 && MERKLE_BITS < 31, "the leaves must be indexable by an int");
+
+/**
+ * Constructor
+ */
+MerkleTree::MerkleTree(): nodes(2 * MERKLE_LEAVES, 0) {}
+
+/**
+ * FUNCTION NAME: mix
+ *
+ * DESCRIPTION: Hash of an internal node from its children, order sensitive. (0, 0) stays 0.
+ */
+uint64_t MerkleTree::mix(uint64_t a, uint64_t b) {
+	if ( 0 == (a | b) ) {
+		return 0;
+	}
+	// splitmix64 finalizer
+	uint64_t x = a * 0x9E3779B97F4A7C15ULL ^ (b + 0xC2B2AE3D27D4EB4FULL);
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ * FUNCTION NAME: itemHash
+ *
+ * DESCRIPTION: Hash of one key with its serialized Entry, version included.
+ * 				RingHash gives the same digests on every node, whatever its build.
+ */
+uint64_t MerkleTree::itemHash(string_view key, string_view entry) {
+	return mix(RingHash::hash(key), RingHash::hash(entry)) | 1;
+}
+
+/**
+ * FUNCTION NAME: toggle
+ *
+ * DESCRIPTION: Add an item to a bucket, or remove it if it is there (XOR)
+ */
+void MerkleTree::toggle(size_t bucket, uint64_t itemHash) {
+	size_t index = MERKLE_LEAVES + bucket;
+	nodes[index] ^= itemHash;
+	for ( index >>= 1; index; index >>= 1 ) {
+		nodes[index] = mix(nodes[2 * index], nodes[2 * index + 1]);
+	}
+}
+
+/**
+ * FUNCTION NAME: pullOnce
+ *
+ * DESCRIPTION: Whether an empty subtree should be pulled, false if it or an ancestor
+ * 				was pulled in the last MERKLE_PULL_WINDOW ticks. Every replica of a range
+ * 				contacts a node that just became responsible for it, one copy is enough.
+ */
+bool MerkleTree::pullOnce(int index, int now) {
+	for ( int i = index; i; i >>= 1 ) {
+		map<int, int>::iterator search = emptyPulls.find(i);
+		if ( search != emptyPulls.end() && now - search->second <= MERKLE_PULL_WINDOW ) {
+			return false;
+		}
+	}
+	emptyPulls[index] = now;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: rangeDigests
+ *
+ * DESCRIPTION: Start comparing buckets lo..hi with a peer: digests of the fewest subtrees
+ * 				exactly covering the range. The subtrees this tree has nothing in are pulled instead.
+ * 				lo > hi is a range wrapping around the ring.
+ */
+void MerkleTree::rangeDigests(size_t lo, size_t hi, int now, vector<pair<int, uint64_t>> *digests, vector<int> *pulls) {
+	if ( lo > hi ) {
+		rangeDigests(lo, MERKLE_LEAVES - 1, now, digests, pulls);
+		rangeDigests(0, hi, now, digests, pulls);
+		return;
+	}
+	vector<int> cover;
+	for ( size_t l = MERKLE_LEAVES + lo, r = MERKLE_LEAVES + hi + 1; l < r; l >>= 1, r >>= 1 ) {
+		if ( l & 1 ) {
+			cover.push_back(l++);
+		}
+		if ( r & 1 ) {
+			cover.push_back(--r);
+		}
+	}
+	for ( int index : cover ) {
+		if ( nodes[index] ) {
+			digests->emplace_back(index, nodes[index]);
+		}
+		else if ( pullOnce(index, now) ) {
+			pulls->push_back(index);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: mark
+ *
+ * DESCRIPTION: Mark every bucket under a node
+ */
+void MerkleTree::mark(int index, vector<bool> *push) {
+	int first = index;
+	int last = index;
+	while ( first < MERKLE_LEAVES ) {
+		first = 2 * first;
+		last = 2 * last + 1;
+	}
+	for ( int i = first; i <= last; i++ ) {
+		(*push)[i - MERKLE_LEAVES] = true;
+	}
+}
+
+/**
+ * FUNCTION NAME: diff
+ *
+ * DESCRIPTION: One step of the comparison with a peer, given the digests and pulls it sent.
+ * 				For each digest that differs from this tree:
+ * 				- the peer has nothing there: push the subtree to it
+ * 				- this tree has nothing there: ask the peer to push it (replyPulls)
+ * 				- a leaf: push the bucket and pull the peer's
+ * 				- otherwise: answer with the digests of both children, pulling the empty ones
+ * 				Pulled subtrees are pushed as well. push is indexed by bucket.
+ * 				The tree nodes must be in 1..2*MERKLE_LEAVES-1, MessageView::decode rejects others.
+ */
+void MerkleTree::diff(const vector<pair<int, uint64_t>> &digests, const vector<int> &pulls, int now,
+		vector<pair<int, uint64_t>> *replyDigests, vector<int> *replyPulls, vector<bool> *push) {
+	for ( const pair<int, uint64_t> &digest : digests ) {
+		int index = digest.first;
+		uint64_t mine = nodes[index];
+		if ( mine == digest.second ) {
+			continue;
+		}
+		if ( 0 == digest.second ) {
+			mark(index, push);
+		}
+		else if ( 0 == mine ) {
+			if ( pullOnce(index, now) ) {
+				replyPulls->push_back(index);
+			}
+		}
+		else if ( index >= MERKLE_LEAVES ) {
+			mark(index, push);
+			replyPulls->push_back(index);
+		}
+		else {
+			for ( int child = 2 * index; child <= 2 * index + 1; child++ ) {
+				if ( nodes[child] ) {
+					replyDigests->emplace_back(child, nodes[child]);
+				}
+				else if ( pullOnce(child, now) ) {
+					replyPulls->push_back(child);
+				}
+			}
+		}
+	}
+	for ( int index : pulls ) {
+		mark(index, push);
+	}
+}
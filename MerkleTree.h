@@ -0,0 +1,58 @@
+/**********************************
+ * FILE NAME: MerkleTree.h
+ *
+ * DESCRIPTION: Header file of the MerkleTree class
+ **********************************/
+
+#ifndef MERKLETREE_H_
+#define MERKLETREE_H_
+
+#include "stdincludes.h"
+#include <stdint.h>
+#include <string_view>
+
+/*
+ * Macros
+ */
+// one leaf (bucket) per 2^(64 - MERKLE_BITS) ring positions
+#define MERKLE_BITS 10
+#define MERKLE_LEAVES (1 << MERKLE_BITS)
+// ticks during which an empty subtree pulled from one replica is not pulled from another
+#define MERKLE_PULL_WINDOW 5
+
+/**
+ * CLASS NAME: MerkleTree
+ *
+ * DESCRIPTION: Hash tree over the keys of a node, bucketed by the top MERKLE_BITS
+ * 				of their ring position. A leaf is the XOR of the hashes of the
+ * 				(key, entry) pairs in its bucket, so a write updates it in O(1) and
+ * 				its path in O(log leaves). An empty subtree hashes to 0.
+ *
+ * 				Nodes are numbered in heap order: 1 is the root, the children of i
+ * 				are 2i and 2i+1, and the leaf of bucket b is MERKLE_LEAVES + b.
+ * 				Two replicas compare a key range by exchanging digests (node, hash),
+ * 				starting from the subtrees covering the range (rangeDigests) and
+ * 				going down only where they differ (diff).
+ */
+class MerkleTree {
+private:
+	vector<uint64_t> nodes;
+	// empty subtree -> time it was last pulled
+	map<int, int> emptyPulls;
+
+	static uint64_t mix(uint64_t a, uint64_t b);
+	static void mark(int index, vector<bool> *push);
+	bool pullOnce(int index, int now);
+
+public:
+	MerkleTree();
+	static size_t bucket(uint64_t position) { return position >> (64 - MERKLE_BITS); }
+	void toggle(size_t bucket, uint64_t itemHash);
+	uint64_t get(int index) { return nodes[index]; }
+	void rangeDigests(size_t lo, size_t hi, int now, vector<pair<int, uint64_t>> *digests, vector<int> *pulls);
+	void diff(const vector<pair<int, uint64_t>> &digests, const vector<int> &pulls, int now,
+			vector<pair<int, uint64_t>> *replyDigests, vector<int> *replyPulls, vector<bool> *push);
+	static uint64_t itemHash(string_view key, string_view entry);
+};
+
+#endif /* MERKLETREE_H_ */
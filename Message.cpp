@@ -4,76 +4,128 @@
  * DESCRIPTION: Message class definition
  **********************************/
 #include "Message.h"
+#include "Wire.h"
+#include "MerkleTree.h"
 
 /**
- * Constructor
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Decode an encoded message in one pass, without copying its strings.
+ * 				False for another wire version, an unknown type or a malformed message,
+ * 				which includes a MERKLE tree node outside 1..2*MERKLE_LEAVES-1.
  */
-// transID::fromAddr::CREATE::key::value::ReplicaType
-// transID::fromAddr::READ::key
-// transID::fromAddr::UPDATE::key::value::ReplicaType
-// transID::fromAddr::DELETE::key
-// transID::fromAddr::REPLY::sucess
-// transID::fromAddr::READREPLY::value
-Message::Message(string message){
-	this->delimiter = "::";
-	vector<string> tuple;
-	size_t pos = message.find(delimiter);
-	size_t start = 0;
-	while (pos != string::npos) {
-		string field = message.substr(start, pos-start);
-		tuple.push_back(field);
-		start = pos + 2;
-		pos = message.find(delimiter, start);
-	}
-	tuple.push_back(message.substr(start));
+bool MessageView::decode(const char *data, size_t size) {
+	if (size < MSG_HEADER_SIZE)
+		return false;
+	WireReader r = {data, data + size, true};
+	version = r.byte();
+	uint8_t t = r.byte();
+	if (version != MSG_WIRE_VERSION || t > MERKLE)
+		return false;
+	type = static_cast<MessageType>(t);
+	memcpy(fromAddr.addr, r.p, sizeof(fromAddr.addr));
+	r.p += sizeof(fromAddr.addr);
+	transID = r.zigzag();
 
-	transID = stoi(tuple.at(0));
-	Address addr(tuple.at(1));
-	fromAddr = addr;
-	type = static_cast<MessageType>(stoi(tuple.at(2)));
+	key = string_view();
+	value = string_view();
+	merkle = string_view();
+	replica = PRIMARY;
+	success = false;
+	timestamp = 0;
+	coordinator = 0;
+	digestCount = 0;
+	pullCount = 0;
 	switch(type){
 		case CREATE:
 		case UPDATE:
-			key = tuple.at(3);
-			value = tuple.at(4);
-			if (tuple.size() > 5)
-				replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
+			key = r.str();
+			value = r.str();
+			replica = static_cast<ReplicaType>(r.byte());
+			timestamp = r.zigzag();
+			coordinator = r.zigzag();
 			break;
 		case READ:
+			key = r.str();
+			break;
 		case DELETE:
-			key = tuple.at(3);
+			key = r.str();
+			timestamp = r.zigzag();
+			coordinator = r.zigzag();
 			break;
 		case REPLY:
-			if (tuple.at(3) == "1")
-				success = true;
-			else
-				success = false;
+			success = r.byte();
 			break;
 		case READREPLY:
-			value = tuple.at(3);
+			value = r.str();
+			timestamp = r.zigzag();
+			coordinator = r.zigzag();
+			break;
+		case MERKLE: {
+			const char *start = r.p;
+			digestCount = r.varint();
+			for (uint32_t i = 0; i < digestCount && r.ok; i++) {
+				uint64_t node = r.varint();
+				r.u64();
+				r.ok = r.ok && node >= 1 && node < 2 * MERKLE_LEAVES;
+			}
+			pullCount = r.varint();
+			for (uint32_t i = 0; i < pullCount && r.ok; i++) {
+				uint64_t node = r.varint();
+				r.ok = r.ok && node >= 1 && node < 2 * MERKLE_LEAVES;
+			}
+			merkle = string_view(start, r.p - start);
 			break;
+		}
+	}
+	return r.ok && r.p == r.end;
+}
+
+/**
+ * Constructor
+ */
+// construct a received message, copying out of the buffer of the view
+Message::Message(const MessageView &view): key(view.key), value(view.value), fromAddr(view.fromAddr) {
+	type = view.type;
+	replica = view.replica;
+	transID = view.transID;
+	success = view.success;
+	timestamp = view.timestamp;
+	coordinator = view.coordinator;
+	if (type == MERKLE) {
+		WireReader r = {view.merkle.data(), view.merkle.data() + view.merkle.size(), true};
+		r.varint();
+		digests.reserve(view.digestCount);
+		for (uint32_t i = 0; i < view.digestCount; i++) {
+			int node = r.varint();
+			digests.emplace_back(node, r.u64());
+		}
+		r.varint();
+		pulls.reserve(view.pullCount);
+		for (uint32_t i = 0; i < view.pullCount; i++)
+			pulls.push_back(r.varint());
 	}
 }
 
 /**
  * Constructor
  */
-// construct a create or update message
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica){
-	this->delimiter = "::";
+// construct a create or update message, or a versioned delete message with an empty value
+Message::Message(int _transID, Address _fromAddr, MessageType _type, const string &_key, const string &_value, ReplicaType _replica, int _timestamp, int _coordinator){
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
 	value = _value;
 	replica = _replica;
+	timestamp = _timestamp;
+	coordinator = _coordinator;
 }
 
 /**
  * Constructor
  */
 Message::Message(const Message& anotherMessage) {
-	this->delimiter = anotherMessage.delimiter;
 	this->fromAddr = anotherMessage.fromAddr;
 	this->key = anotherMessage.key;
 	this->replica = anotherMessage.replica;
@@ -81,30 +133,37 @@ Message::Message(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->timestamp = anotherMessage.timestamp;
+	this->coordinator = anotherMessage.coordinator;
+	this->digests = anotherMessage.digests;
+	this->pulls = anotherMessage.pulls;
 }
 
 /**
  * Constructor
  */
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value){
-	this->delimiter = "::";
+Message::Message(int _transID, Address _fromAddr, MessageType _type, const string &_key, const string &_value){
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
 	value = _value;
+	replica = PRIMARY;
+	timestamp = 0;
+	coordinator = 0;
 }
 
 /**
  * Constructor
  */
 // construct a read or delete message
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key){
-	this->delimiter = "::";
+Message::Message(int _transID, Address _fromAddr, MessageType _type, const string &_key){
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
+	timestamp = 0;
+	coordinator = 0;
 }
 
 /**
@@ -112,59 +171,98 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
  */
 // construct reply message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _success){
-	this->delimiter = "::";
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
 	success = _success;
+	timestamp = 0;
+	coordinator = 0;
 }
 
 /**
  * Constructor
  */
 // construct read reply message
-Message::Message(int _transID, Address _fromAddr, string _value){
-	this->delimiter = "::";
+Message::Message(int _transID, Address _fromAddr, const string &_value, int _timestamp, int _coordinator){
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = READREPLY;
 	value = _value;
+	timestamp = _timestamp;
+	coordinator = _coordinator;
 }
 
 /**
- * FUNCTION NAME: toString
+ * Constructor
+ */
+// construct merkle message
+Message::Message(int _transID, Address _fromAddr, const vector<pair<int, uint64_t>> &_digests, const vector<int> &_pulls){
+	transID = _transID;
+	fromAddr = _fromAddr;
+	type = MERKLE;
+	digests = _digests;
+	pulls = _pulls;
+	timestamp = 0;
+	coordinator = 0;
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Serialize the message into buffer in one pass, see the layout in Message.h
  *
- * DESCRIPTION: Serialized Message in string format
+ * RETURNS:
+ * bytes written, 0 if capacity is too small
  */
-string Message::toString(){
-	string message = to_string(transID) + delimiter + fromAddr.getAddress() + delimiter + to_string(type) + delimiter;
+size_t Message::encode(char *buffer, size_t capacity) const {
+	WireWriter w = {buffer, buffer + capacity, true};
+	w.byte(MSG_WIRE_VERSION);
+	w.byte(type);
+	w.bytes(fromAddr.addr, sizeof(fromAddr.addr));
+	w.zigzag(transID);
 	switch(type){
 		case CREATE:
 		case UPDATE:
-			message += key + delimiter + value + delimiter + to_string(replica);
+			w.str(key);
+			w.str(value);
+			w.byte(replica);
+			w.zigzag(timestamp);
+			w.zigzag(coordinator);
 			break;
 		case READ:
+			w.str(key);
+			break;
 		case DELETE:
-			message += key;
+			w.str(key);
+			w.zigzag(timestamp);
+			w.zigzag(coordinator);
 			break;
 		case REPLY:
-			if (success)
-				message += "1";
-			else
-				message += "0";
+			w.byte(success);
 			break;
 		case READREPLY:
-			message += value;
+			w.str(value);
+			w.zigzag(timestamp);
+			w.zigzag(coordinator);
+			break;
+		case MERKLE:
+			w.varint(digests.size());
+			for (const pair<int, uint64_t> &digest : digests) {
+				w.varint(digest.first);
+				w.u64(digest.second);
+			}
+			w.varint(pulls.size());
+			for (int pull : pulls)
+				w.varint(pull);
 			break;
 	}
-	return message;
+	return w.ok ? w.p - buffer : 0;
 }
 
 /**
  * Assignment operator overloading
  */
 Message& Message::operator =(const Message& anotherMessage) {
-	this->delimiter = anotherMessage.delimiter;
 	this->fromAddr = anotherMessage.fromAddr;
 	this->key = anotherMessage.key;
 	this->replica = anotherMessage.replica;
@@ -172,5 +270,9 @@ Message& Message::operator =(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->timestamp = anotherMessage.timestamp;
+	this->coordinator = anotherMessage.coordinator;
+	this->digests = anotherMessage.digests;
+	this->pulls = anotherMessage.pulls;
 	return *this;
 }
@@ -9,11 +9,58 @@
 #include "stdincludes.h"
 #include "Member.h"
 #include "common.h"
+#include <stdint.h>
+#include <string_view>
+
+/**
+ * Macros
+ */
+// first byte of every encoded message, bumped when the layout changes
+#define MSG_WIRE_VERSION 2
+// version, type and sender address
+#define MSG_HEADER_SIZE 8
+
+/**
+ * CLASS NAME: MessageView
+ *
+ * DESCRIPTION: A received message decoded in place: key and value point into the
+ * 				buffer it was decoded from, which must outlive the view.
+ * 				MERKLE entries stay encoded in merkle, Message(const MessageView &)
+ * 				expands them.
+ */
+class MessageView {
+public:
+	int version;
+	MessageType type;
+	Address fromAddr;
+	int transID;
+	string_view key;
+	string_view value;
+	ReplicaType replica;
+	bool success;
+	int timestamp;
+	int coordinator;
+	uint32_t digestCount;
+	uint32_t pullCount;
+	string_view merkle;
+	bool decode(const char *data, size_t size);
+};
 
 /**
  * CLASS NAME: Message
  *
- * DESCRIPTION: This class is used for message passing among nodes
+ * DESCRIPTION: This class is used for message passing among nodes.
+ * 				On the wire a message is MSG_WIRE_VERSION, the type and the 6 bytes of
+ * 				the sender address, then the zigzag varint transID and per type:
+ * 				CREATE/UPDATE	key, value, replica byte, timestamp, coordinator
+ * 				READ			key
+ * 				DELETE			key, timestamp, coordinator
+ * 				REPLY			success byte
+ * 				READREPLY		value, timestamp, coordinator
+ * 				MERKLE			digest count, (node varint, 8 byte hash) per digest,
+ * 								pull count, node varint per pull
+ * 				Strings are a varint length followed by the bytes, so they may hold anything.
+ * 				Integers are little-endian, signed ones zigzag encoded.
  */
 class Message{
 public:
@@ -24,23 +71,29 @@ public:
 	Address fromAddr;
 	int transID;
 	bool success; // success or not 
-	// delimiter
-	string delimiter;
-	// construct a message from a string
-	Message(string message);
+	// version of the value carried by CREATE, UPDATE and READREPLY, or of the DELETE, see Entry
+	int timestamp;
+	int coordinator;
+	// MERKLE: (tree node, hash) to compare and tree nodes to push back, see MerkleTree
+	vector<pair<int, uint64_t>> digests;
+	vector<int> pulls;
+	// construct a received message
+	Message(const MessageView &view);
 	Message(const Message& anotherMessage);
-	// construct a create or update message
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value);
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica);
+	// construct a create or update message, or a versioned delete message with an empty value
+	Message(int _transID, Address _fromAddr, MessageType _type, const string &_key, const string &_value);
+	Message(int _transID, Address _fromAddr, MessageType _type, const string &_key, const string &_value, ReplicaType _replica, int _timestamp = 0, int _coordinator = 0);
 	// construct a read or delete message
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key);
+	Message(int _transID, Address _fromAddr, MessageType _type, const string &_key);
 	// construct reply message
 	Message(int _transID, Address _fromAddr, MessageType _type, bool _success);
 	// construct read reply message
-	Message(int _transID, Address _fromAddr, string _value);
+	Message(int _transID, Address _fromAddr, const string &_value, int _timestamp = 0, int _coordinator = 0);
+	// construct merkle message
+	Message(int _transID, Address _fromAddr, const vector<pair<int, uint64_t>> &_digests, const vector<int> &_pulls);
 	Message& operator = (const Message& anotherMessage);
-	// serialize to a string
-	string toString();
+	// serialize into buffer, 0 if it does not fit
+	size_t encode(char *buffer, size_t capacity) const;
 };
 
 #endif
@@ -0,0 +1,213 @@
+/**********************************
+ * FILE NAME: MessageCodecBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of the KV message codec: size and nanoseconds per
+ * 				message of the former '::' text format against the binary format,
+ * 				encoded, decoded to a MessageView, and decoded to a Message, for
+ * 				CREATE, READREPLY, REPLY and a full MERKLE message
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./MessageCodecBench [iterations, default 1000000]
+ **********************************/
+
+#include "Message.h"
+#include <chrono>
+
+#define TEXT_DELIMITER "::"
+
+/**
+ * FUNCTION NAME: nsPerOp
+ *
+ * DESCRIPTION: Average nanoseconds per operation since start
+ */
+static double nsPerOp(chrono::steady_clock::time_point start, size_t ops) {
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+/**
+ * FUNCTION NAME: textEncode
+ *
+ * DESCRIPTION: The former Message::toString
+ */
+static string textEncode(Message &msg) {
+	string message = to_string(msg.transID) + TEXT_DELIMITER + msg.fromAddr.getAddress() + TEXT_DELIMITER + to_string(msg.type) + TEXT_DELIMITER;
+	switch(msg.type){
+		case CREATE:
+		case UPDATE:
+			message += msg.key + TEXT_DELIMITER + msg.value + TEXT_DELIMITER + to_string(msg.replica) + TEXT_DELIMITER + to_string(msg.timestamp) + TEXT_DELIMITER + to_string(msg.coordinator);
+			break;
+		case READ:
+		case DELETE:
+			message += msg.key;
+			break;
+		case REPLY:
+			message += msg.success ? "1" : "0";
+			break;
+		case READREPLY:
+			message += msg.value + TEXT_DELIMITER + to_string(msg.timestamp) + TEXT_DELIMITER + to_string(msg.coordinator);
+			break;
+		case MERKLE: {
+			char hex[24];
+			for (size_t i = 0; i < msg.digests.size(); i++) {
+				snprintf(hex, sizeof(hex), ":%llx", (unsigned long long)msg.digests[i].second);
+				message += (i ? "," : "") + to_string(msg.digests[i].first) + hex;
+			}
+			message += TEXT_DELIMITER;
+			for (size_t i = 0; i < msg.pulls.size(); i++) {
+				message += (i ? "," : "") + to_string(msg.pulls[i]);
+			}
+			break;
+		}
+	}
+	return message;
+}
+
+/**
+ * FUNCTION NAME: textDecode
+ *
+ * DESCRIPTION: The former Message(string) constructor
+ */
+static Message textDecode(const string &message) {
+	vector<string> tuple;
+	size_t pos = message.find(TEXT_DELIMITER);
+	size_t start = 0;
+	while (pos != string::npos) {
+		tuple.push_back(message.substr(start, pos-start));
+		start = pos + 2;
+		pos = message.find(TEXT_DELIMITER, start);
+	}
+	tuple.push_back(message.substr(start));
+
+	Message msg(stoi(tuple.at(0)), Address(tuple.at(1)), static_cast<MessageType>(stoi(tuple.at(2))), "");
+	switch(msg.type){
+		case CREATE:
+		case UPDATE:
+			msg.key = tuple.at(3);
+			msg.value = tuple.at(4);
+			msg.replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
+			msg.timestamp = stoi(tuple.at(6));
+			msg.coordinator = stoi(tuple.at(7));
+			break;
+		case READ:
+		case DELETE:
+			msg.key = tuple.at(3);
+			break;
+		case REPLY:
+			msg.success = tuple.at(3) == "1";
+			break;
+		case READREPLY:
+			msg.value = tuple.at(3);
+			msg.timestamp = stoi(tuple.at(4));
+			msg.coordinator = stoi(tuple.at(5));
+			break;
+		case MERKLE: {
+			char *p = &tuple.at(3)[0];
+			while (*p) {
+				int node = strtol(p, &p, 10);
+				uint64_t hash = strtoull(p + 1, &p, 16);
+				msg.digests.emplace_back(node, hash);
+				if (*p == ',')
+					p++;
+			}
+			p = &tuple.at(4)[0];
+			while (*p) {
+				msg.pulls.push_back(strtol(p, &p, 10));
+				if (*p == ',')
+					p++;
+			}
+			break;
+		}
+	}
+	return msg;
+}
+
+/**
+ * FUNCTION NAME: sameMessage
+ *
+ * DESCRIPTION: Whether a decoded message carries the fields of the original
+ */
+static bool sameMessage(Message &a, Message b) {
+	return a.type == b.type && a.transID == b.transID && a.fromAddr == b.fromAddr && a.key == b.key
+			&& a.value == b.value && a.timestamp == b.timestamp && a.coordinator == b.coordinator
+			&& a.digests == b.digests && a.pulls == b.pulls
+			&& (a.type != REPLY || a.success == b.success)
+			&& ((a.type != CREATE && a.type != UPDATE) || a.replica == b.replica);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+	Address from("7:0");
+	vector<pair<int, uint64_t>> digests;
+	vector<int> pulls;
+	uint64_t seed = 1;
+	for ( int i = 0; i < 64; i++ ) {
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+		digests.emplace_back(1024 + 16 * i, seed);
+		pulls.push_back(1024 + 16 * i + 8);
+	}
+	vector<pair<const char *, Message>> messages = {
+		{"CREATE", Message(1234, from, CREATE, "key1234", "value of key 1234", SECONDARY, 4521, 7)},
+		{"READREPLY", Message(1234, from, "value of key 1234", 4521, 7)},
+		{"REPLY", Message(1234, from, REPLY, true)},
+		{"MERKLE", Message(-777, from, digests, pulls)},
+	};
+
+	static char buffer[1 << 16];
+	printf("%10s %10s %10s %12s %12s %12s %12s %12s\n", "type", "text B", "binary B",
+			"text enc ns", "text dec ns", "bin enc ns", "view ns", "bin dec ns");
+	for ( pair<const char *, Message> &entry : messages ) {
+		Message &msg = entry.second;
+		string text = textEncode(msg);
+		size_t size = msg.encode(buffer, sizeof(buffer));
+		MessageView view;
+		assert(size && view.decode(buffer, size));
+		assert(sameMessage(msg, Message(view)) && sameMessage(msg, textDecode(text)));
+		assert(!view.decode(buffer, size - 1));
+
+		size_t checksum = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < iterations; i++ ) {
+			checksum += textEncode(msg).size();
+		}
+		double textEncodeNs = nsPerOp(start, iterations);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < iterations; i++ ) {
+			checksum += textDecode(text).transID;
+		}
+		double textDecodeNs = nsPerOp(start, iterations);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < iterations; i++ ) {
+			checksum += msg.encode(buffer, sizeof(buffer));
+		}
+		double encodeNs = nsPerOp(start, iterations);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < iterations; i++ ) {
+			checksum += view.decode(buffer, size) + view.transID;
+		}
+		double viewNs = nsPerOp(start, iterations);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < iterations; i++ ) {
+			view.decode(buffer, size);
+			checksum += Message(view).transID;
+		}
+		double decodeNs = nsPerOp(start, iterations);
+
+		printf("%10s %10zu %10zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", entry.first, text.size(), size,
+				textEncodeNs, textDecodeNs, encodeNs, viewNs, decodeNs);
+		if ( 0 == checksum ) {
+			printf("\n");
+		}
+	}
+	return SUCCESS;
+}
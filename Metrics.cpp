@@ -0,0 +1,315 @@
+/**********************************
+ * FILE NAME: Metrics.cpp
+ *
+ * DESCRIPTION: Definition of the Metrics registry
+ **********************************/
+
+#include "Metrics.h"
+
+/**
+ * FUNCTION NAME: shardIndex
+ *
+ * DESCRIPTION: Each thread is given its own shard the first time it touches a metric
+ */
+static int shardIndex() {
+	static atomic<int> nextShard(0);
+	static thread_local int shard = nextShard.fetch_add(1) % METRICS_SHARDS;
+	return shard;
+}
+
+/**
+ * FUNCTION NAME: writeSample
+ *
+ * DESCRIPTION: Write one "name{labels} value" line
+ */
+static void writeSample(FILE *fp, const string &name, const string &labels, long value) {
+	if ( labels.empty() ) {
+		fprintf(fp, "%s %ld\n", name.c_str(), value);
+	}
+	else {
+		fprintf(fp, "%s{%s} %ld\n", name.c_str(), labels.c_str(), value);
+	}
+}
+
+/**
+ * FUNCTION NAME: inc
+ *
+ * DESCRIPTION: Add v to this thread's shard
+ */
+void Counter::inc(long v) {
+	shards[shardIndex()].value.fetch_add(v, memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: get
+ *
+ * DESCRIPTION: Merge all shards
+ */
+long Counter::get() {
+	long total = 0;
+	for ( int i = 0; i < METRICS_SHARDS; i++ ) {
+		total += shards[i].value.load(memory_order_relaxed);
+	}
+	return total;
+}
+
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Write the counter in exposition format
+ */
+void Counter::write(FILE *fp, const string &name) {
+	writeSample(fp, name, labels, get());
+}
+
+/**
+ * FUNCTION NAME: set
+ *
+ * DESCRIPTION: setter
+ */
+void Gauge::set(long v) {
+	value.store(v, memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: inc
+ *
+ * DESCRIPTION: Increase the gauge by v
+ */
+void Gauge::inc(long v) {
+	value.fetch_add(v, memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: dec
+ *
+ * DESCRIPTION: Decrease the gauge by v
+ */
+void Gauge::dec(long v) {
+	value.fetch_sub(v, memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: get
+ *
+ * DESCRIPTION: getter
+ */
+long Gauge::get() {
+	return value.load(memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Write the gauge in exposition format
+ */
+void Gauge::write(FILE *fp, const string &name) {
+	writeSample(fp, name, labels, get());
+}
+
+/**
+ * Constructor
+ */
+Histogram::Histogram(string labels, const vector<long> &bounds): Metric(labels), bounds(bounds) {
+	buckets = new MetricShard[METRICS_SHARDS * (bounds.size() + 1)];
+}
+
+/**
+ * Destructor
+ */
+Histogram::~Histogram() {
+	delete[] buckets;
+}
+
+/**
+ * FUNCTION NAME: observe
+ *
+ * DESCRIPTION: Record one observation in the first bucket whose bound is >= v
+ */
+void Histogram::observe(long v) {
+	int shard = shardIndex();
+	size_t i = 0;
+	while ( i < bounds.size() && v > bounds[i] ) {
+		i++;
+	}
+	buckets[shard * (bounds.size() + 1) + i].value.fetch_add(1, memory_order_relaxed);
+	sums[shard].value.fetch_add(v, memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Write cumulative buckets, sum and count in exposition format
+ */
+void Histogram::write(FILE *fp, const string &name) {
+	string prefix = labels.empty() ? "" : labels + ",";
+	long cumulative = 0;
+	long sum = 0;
+	for ( size_t i = 0; i <= bounds.size(); i++ ) {
+		for ( int s = 0; s < METRICS_SHARDS; s++ ) {
+			cumulative += buckets[s * (bounds.size() + 1) + i].value.load(memory_order_relaxed);
+		}
+		string le = i < bounds.size() ? to_string(bounds[i]) : "+Inf";
+		writeSample(fp, name + "_bucket", prefix + "le=\"" + le + "\"", cumulative);
+	}
+	for ( int s = 0; s < METRICS_SHARDS; s++ ) {
+		sum += sums[s].value.load(memory_order_relaxed);
+	}
+	writeSample(fp, name + "_sum", labels, sum);
+	writeSample(fp, name + "_count", labels, cumulative);
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the metric of this family with the given labels, NULL if none
+ */
+Metric * MetricFamily::find(const string &labels) {
+	for ( size_t i = 0; i < metrics.size(); i++ ) {
+		if ( metrics[i]->labels == labels ) {
+			return metrics[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Destructor
+ */
+MetricFamily::~MetricFamily() {
+	for ( size_t i = 0; i < metrics.size(); i++ ) {
+		delete metrics[i];
+	}
+}
+
+/**
+ * Constructor
+ */
+Metrics::Metrics(Params *p) {
+	par = p;
+}
+
+/**
+ * Destructor
+ */
+Metrics::~Metrics() {
+	for ( size_t i = 0; i < families.size(); i++ ) {
+		delete families[i];
+	}
+}
+
+/**
+ * FUNCTION NAME: label
+ *
+ * DESCRIPTION: Format a label pair as name="value"
+ */
+string Metrics::label(const string &name, const string &value) {
+	return name + "=\"" + value + "\"";
+}
+
+/**
+ * FUNCTION NAME: label
+ *
+ * DESCRIPTION: Format two label pairs
+ */
+string Metrics::label(const string &name, const string &value, const string &name2, const string &value2) {
+	return label(name, value) + "," + label(name2, value2);
+}
+
+/**
+ * FUNCTION NAME: family
+ *
+ * DESCRIPTION: Returns the family with this name, creating it on first use
+ */
+MetricFamily * Metrics::family(const string &name, const string &help, const string &type) {
+	map<string, MetricFamily *>::iterator search = byName.find(name);
+	if ( search != byName.end() ) {
+		assert(search->second->type == type);
+		return search->second;
+	}
+	MetricFamily *f = new MetricFamily(name, help, type);
+	families.push_back(f);
+	byName[name] = f;
+	return f;
+}
+
+/**
+ * FUNCTION NAME: counter
+ *
+ * DESCRIPTION: Register (or look up) a counter. Registering the same name and labels twice returns the same handle.
+ */
+Counter * Metrics::counter(string name, string help, string labels) {
+	MetricFamily *f = family(name, help, "counter");
+	Metric *m = f->find(labels);
+	if ( NULL == m ) {
+		m = new Counter(labels);
+		f->metrics.push_back(m);
+	}
+	return (Counter *)m;
+}
+
+/**
+ * FUNCTION NAME: gauge
+ *
+ * DESCRIPTION: Register (or look up) a gauge
+ */
+Gauge * Metrics::gauge(string name, string help, string labels) {
+	MetricFamily *f = family(name, help, "gauge");
+	Metric *m = f->find(labels);
+	if ( NULL == m ) {
+		m = new Gauge(labels);
+		f->metrics.push_back(m);
+	}
+	return (Gauge *)m;
+}
+
+/**
+ * FUNCTION NAME: histogram
+ *
+ * DESCRIPTION: Register (or look up) a histogram with the given bucket upper bounds
+ */
+Histogram * Metrics::histogram(string name, string help, const vector<long> &bounds, string labels) {
+	MetricFamily *f = family(name, help, "histogram");
+	Metric *m = f->find(labels);
+	if ( NULL == m ) {
+		m = new Histogram(labels, bounds);
+		f->metrics.push_back(m);
+	}
+	return (Histogram *)m;
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: Called once per global time unit. Writes the registry every METRICS_INTERVAL ticks.
+ */
+void Metrics::tick() {
+	if ( par->METRICS_INTERVAL > 0 && par->getcurrtime() % par->METRICS_INTERVAL == 0 ) {
+		dump();
+	}
+}
+
+/**
+ * FUNCTION NAME: dump
+ *
+ * DESCRIPTION: Write all metrics in Prometheus text exposition format.
+ * 				The file is written aside and renamed so readers never see a partial file.
+ */
+void Metrics::dump(const char *file) {
+	string tmp = string(file) + ".tmp";
+	FILE *fp = fopen(tmp.c_str(), "w");
+	if ( NULL == fp ) {
+		return;
+	}
+	fprintf(fp, "# time %d\n", par->getcurrtime());
+	for ( size_t i = 0; i < families.size(); i++ ) {
+		MetricFamily *f = families[i];
+		fprintf(fp, "# HELP %s %s\n", f->name.c_str(), f->help.c_str());
+		fprintf(fp, "# TYPE %s %s\n", f->name.c_str(), f->type.c_str());
+		for ( size_t j = 0; j < f->metrics.size(); j++ ) {
+			f->metrics[j]->write(fp, f->name);
+		}
+	}
+	fclose(fp);
+	rename(tmp.c_str(), file);
+}
@@ -0,0 +1,139 @@
+/**********************************
+ * FILE NAME: Metrics.h
+ *
+ * DESCRIPTION: Header file of the Metrics registry (counters, gauges and
+ * 				histograms exported in Prometheus text format)
+ **********************************/
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include <atomic>
+
+/*
+ * Macros
+ */
+#define METRICS_LOG "metrics.prom"
+// number of per-thread shards a counter is split into
+#define METRICS_SHARDS 16
+#define CACHE_LINE_SIZE 64
+
+/**
+ * STRUCT NAME: MetricShard
+ *
+ * DESCRIPTION: One cache line worth of counter, so that threads updating
+ * 				different shards never share a line
+ */
+struct alignas(CACHE_LINE_SIZE) MetricShard {
+	atomic<long> value;
+	MetricShard(): value(0) {}
+};
+
+/**
+ * CLASS NAME: Metric
+ *
+ * DESCRIPTION: Base class of everything held by the registry
+ */
+class Metric {
+public:
+	string labels;
+	Metric(string labels): labels(labels) {}
+	virtual void write(FILE *fp, const string &name) = 0;
+	virtual ~Metric() {}
+};
+
+/**
+ * CLASS NAME: Counter
+ *
+ * DESCRIPTION: Monotonic counter sharded per thread and merged on read
+ */
+class Counter: public Metric {
+private:
+	MetricShard shards[METRICS_SHARDS];
+public:
+	Counter(string labels): Metric(labels) {}
+	void inc(long v = 1);
+	long get();
+	void write(FILE *fp, const string &name);
+};
+
+/**
+ * CLASS NAME: Gauge
+ *
+ * DESCRIPTION: Value that can go up and down (sizes, queue lengths)
+ */
+class Gauge: public Metric {
+private:
+	atomic<long> value;
+public:
+	Gauge(string labels): Metric(labels), value(0) {}
+	void set(long v);
+	void inc(long v = 1);
+	void dec(long v = 1);
+	long get();
+	void write(FILE *fp, const string &name);
+};
+
+/**
+ * CLASS NAME: Histogram
+ *
+ * DESCRIPTION: Distribution of integer observations over fixed upper bounds.
+ * 				Bucket counts are sharded per thread like Counter.
+ */
+class Histogram: public Metric {
+private:
+	vector<long> bounds;
+	// METRICS_SHARDS rows of (bounds.size() + 1) buckets, the last one is +Inf
+	MetricShard *buckets;
+	MetricShard sums[METRICS_SHARDS];
+public:
+	Histogram(string labels, const vector<long> &bounds);
+	void observe(long v);
+	void write(FILE *fp, const string &name);
+	virtual ~Histogram();
+};
+
+/**
+ * CLASS NAME: MetricFamily
+ *
+ * DESCRIPTION: All the metrics sharing one name, one per label set
+ */
+class MetricFamily {
+public:
+	string name;
+	string help;
+	string type;
+	vector<Metric *> metrics;
+	MetricFamily(string name, string help, string type): name(name), help(help), type(type) {}
+	Metric * find(const string &labels);
+	virtual ~MetricFamily();
+};
+
+/**
+ * CLASS NAME: Metrics
+ *
+ * DESCRIPTION: Registry of all metrics of the run. Metrics are registered
+ * 				once (usually in a constructor) and the returned handle is
+ * 				updated on the hot path without any lookup.
+ */
+class Metrics {
+private:
+	Params *par;
+	vector<MetricFamily *> families;
+	map<string, MetricFamily *> byName;
+	MetricFamily * family(const string &name, const string &help, const string &type);
+public:
+	Metrics(Params *p);
+	virtual ~Metrics();
+	static string label(const string &name, const string &value);
+	static string label(const string &name, const string &value, const string &name2, const string &value2);
+	Counter * counter(string name, string help, string labels = "");
+	Gauge * gauge(string name, string help, string labels = "");
+	Histogram * histogram(string name, string help, const vector<long> &bounds, string labels = "");
+	void tick();
+	void dump(const char *file = METRICS_LOG);
+};
+
+#endif /* _METRICS_H_ */
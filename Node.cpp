@@ -9,13 +9,14 @@
 /**
  * constructor
  */
-Node::Node() {}
+Node::Node(): vnode(0) {}
 
 /**
  * constructor
  */
-Node::Node(Address address) {
+Node::Node(Address address, int vnode) {
 	this->nodeAddress = address;
+	this->vnode = vnode;
 	computeHashCode();
 }
 
@@ -27,10 +28,16 @@ Node::~Node() {}
 /**
  * FUNCTION NAME: computeHashCode
  *
- * DESCRIPTION: This function computes the hash code of the node address
+ * DESCRIPTION: This function computes the hash code of the node address "id:port".
+ * 				Virtual node i > 0 hashes the address followed by #i.
  */
 void Node::computeHashCode() {
-	nodeHashCode = hashFunc(nodeAddress.addr)%RING_SIZE;
+	if ( 0 == vnode ) {
+		nodeHashCode = RingHash::hash(nodeAddress.getAddress());
+	}
+	else {
+		nodeHashCode = RingHash::hash(nodeAddress.getAddress() + "#" + to_string(vnode));
+	}
 }
 
 /**
@@ -39,6 +46,7 @@ void Node::computeHashCode() {
 Node::Node(const Node& another) {
 	this->nodeAddress = another.nodeAddress;
 	this->nodeHashCode = another.nodeHashCode;
+	this->vnode = another.vnode;
 }
 
 /**
@@ -47,14 +55,24 @@ Node::Node(const Node& another) {
 Node& Node::operator=(const Node& another) {
 	this->nodeAddress = another.nodeAddress;
 	this->nodeHashCode = another.nodeHashCode;
+	this->vnode = another.vnode;
 	return *this;
 }
 
 /**
  * operator overloading
+ * Tokens on the same position are ordered by address then virtual node,
+ * so every node builds the same ring from the same membership
  */
 bool Node::operator < (const Node& another) const {
-	return this->nodeHashCode < another.nodeHashCode;
+	if ( this->nodeHashCode != another.nodeHashCode ) {
+		return this->nodeHashCode < another.nodeHashCode;
+	}
+	int order = memcmp(this->nodeAddress.addr, another.nodeAddress.addr, sizeof(this->nodeAddress.addr));
+	if ( order ) {
+		return order < 0;
+	}
+	return this->vnode < another.vnode;
 }
 
 /**
@@ -62,7 +80,7 @@ bool Node::operator < (const Node& another) const {
  *
  * DESCRIPTION: return hash code of the node
  */
-size_t Node::getHashCode() {
+uint64_t Node::getHashCode() {
 	return nodeHashCode;
 }
 
@@ -80,7 +98,7 @@ Address * Node::getAddress() {
  *
  * DESCRIPTION: set the hash code of the node
  */
-void Node::setHashCode(size_t hashCode) {
+void Node::setHashCode(uint64_t hashCode) {
 	this->nodeHashCode = hashCode;
 }
 
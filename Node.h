@@ -9,21 +9,24 @@
 
 #include "stdincludes.h"
 #include "Member.h"
+#include "RingHash.h"
 
 class Node {
 public:
 	Address nodeAddress;
-	size_t nodeHashCode;
-	std::hash<string> hashFunc;
+	// position of this token on the 64-bit ring
+	uint64_t nodeHashCode;
+	// index of this token among the virtual nodes of nodeAddress
+	int vnode;
 	Node();
-	Node(Address address);
+	Node(Address address, int vnode = 0);
 	Node(const Node& another);
 	Node& operator=(const Node& another);
 	bool operator < (const Node& another) const;
 	void computeHashCode();
-	size_t getHashCode();
+	uint64_t getHashCode();
 	Address * getAddress();
-	void setHashCode(size_t hashCode);
+	void setHashCode(uint64_t hashCode);
 	void setAddress(Address address);
 	virtual ~Node();
 };
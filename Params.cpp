@@ -8,8 +8,12 @@
 
 /**
  * Constructor
+ *
+ * DESCRIPTION: Defaults of the optional parameters, for a config file that leaves them out
+ * 				and for the benchmarks that fill a Params without any config file
  */
-Params::Params(): PORTNUM(8001) {}
+Params::Params(): PORTNUM(8001), METRICS_INTERVAL(10), KV_STORAGE(0), VNODES(1), GOSSIP_MODE(0),
+		GOSSIP_FANOUT(0), MEMBERSHIP(0), PHI_THRESHOLD(0), GRACEFUL_LEAVE(0), SEEDS(1) {}
 
 /**
  * FUNCTION NAME: setparams
@@ -19,6 +23,8 @@ Params::Params(): PORTNUM(8001) {}
 void Params::setparams(char *config_file) {
 	//trace.funcEntry("Params::setparams");
 	char CRUD[10];
+	char name[64];
+	char value[64];
 	FILE *fp = fopen(config_file,"r");
 
 	fscanf(fp,"MAX_NNB: %d", &MAX_NNB);
@@ -51,11 +57,57 @@ void Params::setparams(char *config_file) {
 	for ( unsigned int i = 0; i < EN_GPSZ; i++ ) {
 		allNodesJoined += i;
 	}
+
+	// Optional "NAME: value" lines after the mandatory ones
+	while ( 2 == fscanf(fp, " %63[^:]: %63s", name, value) ) {
+		setparam(name, value);
+	}
 	fclose(fp);
 	//trace.funcExit("Params::setparams", SUCCESS);
 	return;
 }
 
+/**
+ * FUNCTION NAME: setparam
+ *
+ * DESCRIPTION: Set one optional parameter of this test case
+ */
+void Params::setparam(char *name, char *value) {
+	if ( 0 == strcmp(name, "METRICS_INTERVAL") ) {
+		METRICS_INTERVAL = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "KV_STORAGE") ) {
+		// values of StorageMode in HashTable.h
+		KV_STORAGE = 0 == strcmp(value, "ARENA") ? 1 : 0;
+	}
+	else if ( 0 == strcmp(name, "VNODES") ) {
+		VNODES = max(1, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "GOSSIP") ) {
+		// values of GossipMode in MP1Node.h
+		GOSSIP_MODE = 0 == strcmp(value, "DELTA") ? 1 : 0;
+	}
+	else if ( 0 == strcmp(name, "GOSSIP_FANOUT") ) {
+		GOSSIP_FANOUT = max(0, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "MEMBERSHIP") ) {
+		// values of MembershipProtocol in MP1Node.h
+		MEMBERSHIP = 0 == strcmp(value, "SWIM") ? 1 : 0;
+	}
+	else if ( 0 == strcmp(name, "PHI_THRESHOLD") ) {
+		PHI_THRESHOLD = max(0.0, atof(value));
+	}
+	else if ( 0 == strcmp(name, "GRACEFUL_LEAVE") ) {
+		GRACEFUL_LEAVE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SEEDS") ) {
+		SEEDS = max(1, atoi(value));
+	}
+	else {
+		printf("Unknown parameter %s in the test case, ignored\n", name);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -32,8 +32,18 @@ public:
 	int allNodesJoined;
 	short PORTNUM;
 	int CRUDTEST;
+	int METRICS_INTERVAL;		// ticks between two metrics dumps, 0 disables
+	int KV_STORAGE;			// StorageMode of the KV store hash tables, INLINE or ARENA
+	int VNODES;			// tokens of each node on the consistent hashing ring
+	int GOSSIP_MODE;		// GossipMode of the membership protocol, FULL or DELTA
+	int GOSSIP_FANOUT;		// peers sent a heartbeat each tick, 0 for about 70% of the members
+	int MEMBERSHIP;			// MembershipProtocol of the membership protocol, GOSSIP or SWIM
+	double PHI_THRESHOLD;		// phi-accrual suspicion a gossip member is removed at, 0 for TREMOVE ticks
+	int GRACEFUL_LEAVE;		// whether the tests stop nodes by a handoff and a LEAVE instead of a crash
+	int SEEDS;			// nodes 1 to SEEDS are the seeds the others join through
 	Params();
 	void setparams(char *);
+	void setparam(char *, char *);
 	int getcurrtime();
 };
 
@@ -0,0 +1,103 @@
+/**********************************
+ * FILE NAME: RingBench.cpp
+ *
+ * DESCRIPTION: Load report of the consistent hashing ring for 1, 8, 64 and 256
+ * 				virtual nodes per node: keys stored by each node (three replicas
+ * 				per key) and, when one node fails, how its keys spread over the
+ * 				nodes that take them. The ring and the replica selection are the
+ * 				ones of MP2Node.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./RingBench [nodes, default 10] [keys, default 100000]
+ **********************************/
+
+#include "MP2Node.h"
+
+/**
+ * FUNCTION NAME: buildRing
+ *
+ * DESCRIPTION: MP2Node::updateRing for the given nodes
+ */
+static vector<Node> buildRing(vector<Address> &nodes, int vnodes) {
+	vector<Node> ring;
+	for ( Address &addr : nodes ) {
+		for ( int v = 0; v < vnodes; v++ ) {
+			ring.emplace_back(addr, v);
+		}
+	}
+	sort(ring.begin(), ring.end());
+	return ring;
+}
+
+/**
+ * FUNCTION NAME: keysPerNode
+ *
+ * DESCRIPTION: Keys each node replicates, indexed by node id - 1
+ */
+static vector<long> keysPerNode(int n, vector<Node> &ring, vector<uint64_t> &positions) {
+	RingIndex index;
+	index.build(ring);
+	vector<long> count(n, 0);
+	for ( uint64_t position : positions ) {
+		const uint32_t *replicas = index.lookup(position);
+		for ( int r = 0; r < RING_REPLICAS; r++ ) {
+			int id;
+			memcpy(&id, &ring[replicas[r]].nodeAddress.addr[0], sizeof(int));
+			count[id - 1]++;
+		}
+	}
+	return count;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 10;
+	long keys = argc > 2 ? atol(argv[2]) : 100000;
+
+	vector<Address> nodes;
+	for ( int i = 1; i <= n; i++ ) {
+		nodes.emplace_back(to_string(i) + ":0");
+	}
+	vector<string> names;
+	for ( long i = 0; i < keys; i++ ) {
+		names.push_back("key" + to_string(i));
+	}
+	vector<string_view> views(names.begin(), names.end());
+	vector<uint64_t> positions(keys);
+	RingHash::hashBatch(views.data(), keys, positions.data());
+
+	printf("%d nodes, %ld keys, node %s fails\n", n, keys, nodes[0].getAddress().c_str());
+	printf("%8s %10s %10s %10s %10s %10s %16s\n", "vnodes", "min keys", "max keys", "mean", "stddev %", "max/mean", "failover max %");
+	for ( int vnodes : {1, 8, 64, 256} ) {
+		vector<Node> ring = buildRing(nodes, vnodes);
+		vector<long> count = keysPerNode(n, ring, positions);
+		double mean = 3.0 * keys / n;
+		double variance = 0;
+		for ( long c : count ) {
+			variance += (c - mean) * (c - mean) / n;
+		}
+
+		// the failed node's keys, spread over the survivors that gained them
+		vector<Address> survivors(nodes.begin() + 1, nodes.end());
+		vector<Node> after = buildRing(survivors, vnodes);
+		vector<long> countAfter = keysPerNode(n, after, positions);
+		long moved = 0;
+		long maxGained = 0;
+		for ( int i = 1; i < n; i++ ) {
+			long gained = countAfter[i] - count[i];
+			moved += gained;
+			maxGained = max(maxGained, gained);
+		}
+
+		printf("%8d %10ld %10ld %10.0f %10.1f %10.2f %16.1f\n", vnodes,
+				*min_element(count.begin(), count.end()), *max_element(count.begin(), count.end()),
+				mean, 100 * sqrt(variance) / mean, *max_element(count.begin(), count.end()) / mean,
+				moved ? 100.0 * maxGained / moved : 0.0);
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,131 @@
+/**********************************
+ * FILE NAME: RingHash.cpp
+ *
+ * DESCRIPTION: Definition of the RingHash class
+ **********************************/
+
+#include "RingHash.h"
+
+static const uint64_t secret[4] = {0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL, 0x8EBC6AF09C88C6E3ULL, 0x589965CC75374CC3ULL};
+
+/**
+ * FUNCTION NAME: mum
+ *
+ * DESCRIPTION: Full 128-bit product of a and b, the low half in *a and the high half in *b
+ */
+static inline void mum(uint64_t *a, uint64_t *b) {
+	__uint128_t r = (__uint128_t)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+}
+
+/**
+ * FUNCTION NAME: mix
+ *
+ * DESCRIPTION: XOR of both halves of the product of a and b
+ */
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+	mum(&a, &b);
+	return a ^ b;
+}
+
+/**
+ * FUNCTION NAME: read64
+ *
+ * DESCRIPTION: 8 bytes as a little-endian integer, whatever the byte order of the host
+ */
+static inline uint64_t read64(const uint8_t *p) {
+	return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+			(uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+/**
+ * FUNCTION NAME: read32
+ *
+ * DESCRIPTION: 4 bytes as a little-endian integer
+ */
+static inline uint64_t read32(const uint8_t *p) {
+	return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24;
+}
+
+/**
+ * FUNCTION NAME: mixSeed
+ *
+ * DESCRIPTION: The seed as every hash with it starts, computed once per batch
+ */
+uint64_t RingHash::mixSeed(uint64_t seed) {
+	return seed ^ mix(seed ^ secret[0], secret[1]);
+}
+
+/**
+ * FUNCTION NAME: hashMixed
+ *
+ * DESCRIPTION: Hash of len bytes given a mixed seed.
+ * 				Up to 16 bytes are read as two overlapping words, longer inputs
+ * 				are consumed 48 then 16 bytes per round, and the last 16 bytes are
+ * 				folded with the length.
+ */
+uint64_t RingHash::hashMixed(const uint8_t *p, size_t len, uint64_t seed) {
+	uint64_t a;
+	uint64_t b;
+	if ( len <= 16 ) {
+		if ( len >= 4 ) {
+			a = read32(p) << 32 | read32(p + ((len >> 3) << 2));
+			b = read32(p + len - 4) << 32 | read32(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if ( len > 0 ) {
+			a = (uint64_t)p[0] << 16 | (uint64_t)p[len >> 1] << 8 | p[len - 1];
+			b = 0;
+		}
+		else {
+			a = b = 0;
+		}
+	}
+	else {
+		size_t i = len;
+		if ( i > 48 ) {
+			uint64_t see1 = seed;
+			uint64_t see2 = seed;
+			do {
+				seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+				see1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ see1);
+				see2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while ( i > 48 );
+			seed ^= see1 ^ see2;
+		}
+		while ( i > 16 ) {
+			seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = read64(p + i - 16);
+		b = read64(p + i - 8);
+	}
+	a ^= secret[1];
+	b ^= seed;
+	mum(&a, &b);
+	return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: Position of len bytes on the ring
+ */
+uint64_t RingHash::hash(const void *data, size_t len, uint64_t seed) {
+	return hashMixed((const uint8_t *)data, len, mixSeed(seed));
+}
+
+/**
+ * FUNCTION NAME: hashBatch
+ *
+ * DESCRIPTION: Positions of n keys, positions[i] = hash(keys[i], seed)
+ */
+void RingHash::hashBatch(const string_view *keys, size_t n, uint64_t *positions, uint64_t seed) {
+	uint64_t mixed = mixSeed(seed);
+	for ( size_t i = 0; i < n; i++ ) {
+		positions[i] = hashMixed((const uint8_t *)keys[i].data(), keys[i].size(), mixed);
+	}
+}
@@ -0,0 +1,42 @@
+/**********************************
+ * FILE NAME: RingHash.h
+ *
+ * DESCRIPTION: Header file of the RingHash class
+ **********************************/
+
+#ifndef RINGHASH_H_
+#define RINGHASH_H_
+
+#include "stdincludes.h"
+#include <stdint.h>
+#include <string_view>
+
+/*
+ * Macros
+ */
+// seed of the ring positions, every node must use the same
+#define RING_HASH_SEED 0x2D358DCCAA6C78A5ULL
+
+/**
+ * CLASS NAME: RingHash
+ *
+ * DESCRIPTION: 64-bit non-cryptographic hash placing keys and nodes on the ring.
+ * 				Same construction as wyhash: 64x64->128 bit multiply-fold rounds
+ * 				over little-endian 8-byte reads, so a given seed gives the same
+ * 				positions on every platform and build, unlike std::hash.
+ * 				hashBatch mixes the seed once for a whole batch of keys.
+ */
+class RingHash {
+private:
+	static uint64_t mixSeed(uint64_t seed);
+	static uint64_t hashMixed(const uint8_t *p, size_t len, uint64_t seed);
+
+public:
+	static uint64_t hash(const void *data, size_t len, uint64_t seed = RING_HASH_SEED);
+	static uint64_t hash(string_view key, uint64_t seed = RING_HASH_SEED) {
+		return hash(key.data(), key.size(), seed);
+	}
+	static void hashBatch(const string_view *keys, size_t n, uint64_t *positions, uint64_t seed = RING_HASH_SEED);
+};
+
+#endif /* RINGHASH_H_ */
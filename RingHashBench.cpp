@@ -0,0 +1,66 @@
+/**********************************
+ * FILE NAME: RingHashBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of the ring hash: std::hash, RingHash::hash one key
+ * 				at a time and RingHash::hashBatch, on short keys and 100 byte keys.
+ * 				Also prints the position of a fixed key, which must be the same on
+ * 				every platform and build.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./RingHashBench [keys, default 1000000]
+ **********************************/
+
+#include "RingHash.h"
+#include <chrono>
+
+/**
+ * FUNCTION NAME: nsPerOp
+ *
+ * DESCRIPTION: Average nanoseconds per operation since start
+ */
+static double nsPerOp(chrono::steady_clock::time_point start, size_t ops) {
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+	printf("position of \"key0\": %016llx\n", (unsigned long long)RingHash::hash(string_view("key0")));
+	printf("%10s %16s %16s %16s\n", "key bytes", "std::hash ns", "hash ns", "hashBatch ns");
+	for ( size_t padding : {0, 90} ) {
+		vector<string> keys;
+		for ( size_t i = 0; i < n; i++ ) {
+			keys.push_back(string(padding, 'k') + "key" + to_string(i));
+		}
+		vector<string_view> views(keys.begin(), keys.end());
+		vector<uint64_t> positions(n);
+		std::hash<string_view> stdHash;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < n; i++ ) {
+			positions[i] = stdHash(views[i]);
+		}
+		double std = nsPerOp(start, n);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < n; i++ ) {
+			positions[i] = RingHash::hash(views[i]);
+		}
+		double single = nsPerOp(start, n);
+
+		vector<uint64_t> batch(n);
+		start = chrono::steady_clock::now();
+		RingHash::hashBatch(views.data(), n, batch.data());
+		double batched = nsPerOp(start, n);
+		assert(batch == positions);
+
+		printf("%10zu %16.1f %16.1f %16.1f\n", keys[n / 2].size(), std, single, batched);
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,82 @@
+/**********************************
+ * FILE NAME: RingIndex.cpp
+ *
+ * DESCRIPTION: Definition of the RingIndex class
+ **********************************/
+
+#include "RingIndex.h"
+
+/**
+ * FUNCTION NAME: build
+ *
+ * DESCRIPTION: Index a ring sorted by position. Each token walks clockwise until
+ * 				it has RING_REPLICAS distinct nodes, a few steps unless a node
+ * 				holds long runs of consecutive tokens.
+ */
+void RingIndex::build(vector<Node> &ring) {
+	size_t n = ring.size();
+	positions.resize(n);
+	replicas.clear();
+	for ( size_t i = 0; i < n; i++ ) {
+		positions[i] = ring[i].getHashCode();
+	}
+	replicas.reserve(n * RING_REPLICAS);
+	for ( size_t i = 0; i < n; i++ ) {
+		int found = 0;
+		for ( size_t k = 0; k < n && found < RING_REPLICAS; k++ ) {
+			uint32_t j = (i + k) % n;
+			bool picked = false;
+			for ( int r = 0; r < found && !picked; r++ ) {
+				picked = 0 == memcmp(ring[replicas[i * RING_REPLICAS + r]].nodeAddress.addr, ring[j].nodeAddress.addr, sizeof(ring[j].nodeAddress.addr));
+			}
+			if ( !picked ) {
+				replicas.push_back(j);
+				found++;
+			}
+		}
+		if ( found < RING_REPLICAS ) {
+			// fewer nodes than replicas, as many on every walk
+			replicas.clear();
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: lowerBound
+ *
+ * DESCRIPTION: Index of the first token at or after position, size() if there is none.
+ * 				The halving loop has a fixed trip count for a given size and its only
+ * 				data dependent step compiles to a conditional move.
+ */
+size_t RingIndex::lowerBound(uint64_t position) const {
+	size_t n = positions.size();
+	if ( 0 == n ) {
+		return 0;
+	}
+	const uint64_t *base = positions.data();
+	while ( n > 1 ) {
+		size_t half = n / 2;
+		base = base[half] < position ? base + half : base;
+		n -= half;
+	}
+	return base - positions.data() + (*base < position);
+}
+
+/**
+ * FUNCTION NAME: lookup
+ *
+ * DESCRIPTION: The RING_REPLICAS ring indices of the replicas of a position,
+ * 				NULL with fewer than RING_REPLICAS nodes. Points into the index.
+ */
+const uint32_t * RingIndex::lookup(uint64_t position) const {
+	if ( replicas.empty() ) {
+		return NULL;
+	}
+	size_t i = lowerBound(position);
+	// past the last token, the range wraps around to the first
+	if ( i == positions.size() ) {
+		i = 0;
+	}
+	return &replicas[i * RING_REPLICAS];
+}
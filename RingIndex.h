@@ -0,0 +1,42 @@
+/**********************************
+ * FILE NAME: RingIndex.h
+ *
+ * DESCRIPTION: Header file of the RingIndex class
+ **********************************/
+
+#ifndef RINGINDEX_H_
+#define RINGINDEX_H_
+
+#include "stdincludes.h"
+#include "Node.h"
+#include <stdint.h>
+
+/*
+ * Macros
+ */
+// replicas of every key
+#define RING_REPLICAS 3
+
+/**
+ * CLASS NAME: RingIndex
+ *
+ * DESCRIPTION: Lookup structure over a sorted ring, rebuilt when the ring changes.
+ * 				positions holds the position of every token, so a lookup is a
+ * 				binary search over one contiguous array, and replicas holds for
+ * 				every token the ring indices of the RING_REPLICAS tokens of distinct
+ * 				nodes its range is stored on, as MP2Node::findNodes would walk them.
+ */
+class RingIndex {
+private:
+	vector<uint64_t> positions;
+	// RING_REPLICAS ring indices per token, empty with fewer than RING_REPLICAS nodes
+	vector<uint32_t> replicas;
+
+public:
+	void build(vector<Node> &ring);
+	size_t lowerBound(uint64_t position) const;
+	const uint32_t * lookup(uint64_t position) const;
+	size_t size() const { return positions.size(); }
+};
+
+#endif /* RINGINDEX_H_ */
@@ -0,0 +1,95 @@
+/**********************************
+ * FILE NAME: RingIndexBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of replica lookup on rings of 10, 1000 and 100000
+ * 				positions: the linear MP2Node::findNodes, findNodes over a RingIndex,
+ * 				and the RingIndex replica triple the client APIs use
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./RingIndexBench [lookups, default 1000000]
+ **********************************/
+
+#include "MP2Node.h"
+#include <chrono>
+
+/**
+ * FUNCTION NAME: nsPerOp
+ *
+ * DESCRIPTION: Average nanoseconds per operation since start
+ */
+static double nsPerOp(chrono::steady_clock::time_point start, size_t ops) {
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+/**
+ * FUNCTION NAME: lcg
+ *
+ * DESCRIPTION: Next pseudo random 64-bit position
+ */
+static uint64_t lcg(uint64_t *seed) {
+	*seed = *seed * 6364136223846793005UL + 1442695040888963407UL;
+	return *seed;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	size_t lookups = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+	printf("%10s %16s %16s %16s\n", "positions", "linear ns", "index ns", "triple ns");
+	for ( size_t n : {10, 1000, 100000} ) {
+		// one token per node at a pseudo random position
+		uint64_t seed = n;
+		vector<Node> ring;
+		for ( size_t i = 0; i < n; i++ ) {
+			ring.emplace_back(Address(to_string(i + 1) + ":0"));
+			ring.back().setHashCode(lcg(&seed));
+		}
+		sort(ring.begin(), ring.end());
+		RingIndex index;
+		index.build(ring);
+
+		vector<uint64_t> positions(lookups);
+		for ( uint64_t &position : positions ) {
+			position = lcg(&seed);
+		}
+		// the linear scan gets fewer lookups on big rings, about the same time overall
+		size_t linearLookups = min(lookups, (size_t)100000000 / n + 1);
+		for ( size_t i = 0; i < linearLookups; i += 97 ) {
+			vector<Node> expected = MP2Node::findNodes(positions[i], ring);
+			const uint32_t *triple = index.lookup(positions[i]);
+			for ( int r = 0; r < RING_REPLICAS; r++ ) {
+				assert(expected[r].nodeAddress == ring[triple[r]].nodeAddress);
+			}
+		}
+
+		size_t checksum = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < linearLookups; i++ ) {
+			checksum += MP2Node::findNodes(positions[i], ring)[0].nodeAddress.addr[0];
+		}
+		double linear = nsPerOp(start, linearLookups);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < lookups; i++ ) {
+			checksum += MP2Node::findNodes(positions[i], ring, index)[0].nodeAddress.addr[0];
+		}
+		double indexed = nsPerOp(start, lookups);
+
+		start = chrono::steady_clock::now();
+		for ( size_t i = 0; i < lookups; i++ ) {
+			checksum += index.lookup(positions[i])[0];
+		}
+		double triple = nsPerOp(start, lookups);
+
+		printf("%10zu %16.1f %16.1f %16.1f\n", n, linear, indexed, triple);
+		if ( 0 == checksum ) {
+			printf("\n");
+		}
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,254 @@
+/**********************************
+ * FILE NAME: SlabArena.cpp
+ *
+ * DESCRIPTION: Definition of the SlabArena class
+ **********************************/
+
+#include "SlabArena.h"
+
+/**
+ * FUNCTION NAME: varintSize
+ *
+ * DESCRIPTION: Bytes needed to encode n 7 bits at a time
+ */
+static uint32_t varintSize(uint32_t n) {
+	uint32_t size = 1;
+	while ( n >= 0x80 ) {
+		n >>= 7;
+		size++;
+	}
+	return size;
+}
+
+/**
+ * FUNCTION NAME: readVarint
+ *
+ * DESCRIPTION: Decode a length prefix, returns its size in bytes
+ */
+static uint32_t readVarint(const char *p, uint32_t *n) {
+	uint32_t value = 0;
+	uint32_t size = 0;
+	uint8_t byte;
+	do {
+		byte = (uint8_t)p[size];
+		value |= (uint32_t)(byte & 0x7F) << (7 * size);
+		size++;
+	} while ( byte & 0x80 );
+	*n = value;
+	return size;
+}
+
+/**
+ * Constructor
+ */
+SlabArena::SlabArena() {
+	liveBytes = 0;
+	deadBytes = 0;
+	allocatedBytes = 0;
+	current = newSlab(1);
+}
+
+/**
+ * Destructor
+ */
+SlabArena::~SlabArena() {
+	for ( size_t i = 0; i < slabs.size(); i++ ) {
+		if ( slabs[i] && slabSpan[i] ) {
+			free(slabs[i]);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: newSlab
+ *
+ * DESCRIPTION: Allocate a slab spanning span indices. Single slabs reuse freed indices.
+ */
+uint32_t SlabArena::newSlab(uint32_t span) {
+	uint32_t index;
+	if ( span == 1 && !freeSlabs.empty() ) {
+		index = freeSlabs.back();
+		freeSlabs.pop_back();
+	}
+	else {
+		index = slabs.size();
+		// offsets are 32 bits
+		assert((uint64_t)(index + span) * ARENA_SLAB_SIZE <= ARENA_NULL_REF);
+		slabs.resize(index + span, NULL);
+		slabUsed.resize(index + span, 0);
+		slabLive.resize(index + span, 0);
+		slabSpan.resize(index + span, 0);
+		slabMarked.resize(index + span, false);
+	}
+	char *buffer = (char *)malloc((size_t)span * ARENA_SLAB_SIZE);
+	for ( uint32_t i = 0; i < span; i++ ) {
+		slabs[index + i] = buffer + (size_t)i * ARENA_SLAB_SIZE;
+	}
+	slabUsed[index] = 0;
+	slabLive[index] = 0;
+	slabSpan[index] = span;
+	slabMarked[index] = false;
+	allocatedBytes += (size_t)span * ARENA_SLAB_SIZE;
+	return index;
+}
+
+/**
+ * FUNCTION NAME: freeSlab
+ *
+ * DESCRIPTION: Give a slab whose strings are all released back to the system
+ */
+void SlabArena::freeSlab(uint32_t index) {
+	uint32_t span = slabSpan[index];
+	deadBytes -= slabUsed[index] - slabLive[index];
+	allocatedBytes -= (size_t)span * ARENA_SLAB_SIZE;
+	free(slabs[index]);
+	for ( uint32_t i = 0; i < span; i++ ) {
+		slabs[index + i] = NULL;
+		slabSpan[index + i] = 0;
+	}
+	slabUsed[index] = 0;
+	slabLive[index] = 0;
+	slabMarked[index] = false;
+	if ( span == 1 ) {
+		freeSlabs.push_back(index);
+	}
+}
+
+/**
+ * FUNCTION NAME: put
+ *
+ * DESCRIPTION: Append a string
+ *
+ * RETURNS:
+ * reference to the string
+ */
+uint32_t SlabArena::put(string_view s) {
+	uint32_t size = varintSize(s.size()) + s.size();
+	uint32_t index;
+	if ( size > ARENA_SLAB_SIZE ) {
+		// gets a slab of its own
+		index = newSlab((size + ARENA_SLAB_SIZE - 1) / ARENA_SLAB_SIZE);
+	}
+	else {
+		if ( slabUsed[current] + size > ARENA_SLAB_SIZE ) {
+			uint32_t sealed = current;
+			current = newSlab(1);
+			if ( slabLive[sealed] == 0 ) {
+				freeSlab(sealed);
+			}
+		}
+		index = current;
+	}
+	char *p = slabs[index] + slabUsed[index];
+	uint32_t n = s.size();
+	while ( n >= 0x80 ) {
+		*p++ = (char)(n | 0x80);
+		n >>= 7;
+	}
+	*p++ = (char)n;
+	memcpy(p, s.data(), s.size());
+
+	uint32_t ref = index * ARENA_SLAB_SIZE + slabUsed[index];
+	slabUsed[index] += size;
+	slabLive[index] += size;
+	liveBytes += size;
+	return ref;
+}
+
+/**
+ * FUNCTION NAME: get
+ *
+ * DESCRIPTION: The string behind a reference. Valid until it is released.
+ */
+string_view SlabArena::get(uint32_t ref) {
+	const char *p = slabs[ref / ARENA_SLAB_SIZE] + ref % ARENA_SLAB_SIZE;
+	uint32_t n;
+	p += readVarint(p, &n);
+	return string_view(p, n);
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: The string is no longer referenced. Its bytes are dead until the slab goes away.
+ */
+void SlabArena::release(uint32_t ref) {
+	uint32_t index = ref / ARENA_SLAB_SIZE;
+	uint32_t n;
+	uint32_t size = readVarint(slabs[index] + ref % ARENA_SLAB_SIZE, &n);
+	size += n;
+	slabLive[index] -= size;
+	liveBytes -= size;
+	deadBytes += size;
+	if ( slabLive[index] == 0 && index != current ) {
+		freeSlab(index);
+	}
+}
+
+/**
+ * FUNCTION NAME: fragmentation
+ *
+ * DESCRIPTION: Fraction of the written bytes that are dead
+ */
+double SlabArena::fragmentation() {
+	if ( liveBytes + deadBytes == 0 ) {
+		return 0;
+	}
+	return (double)deadBytes / (liveBytes + deadBytes);
+}
+
+/**
+ * FUNCTION NAME: memoryUsage
+ *
+ * DESCRIPTION: Bytes held by the arena
+ */
+size_t SlabArena::memoryUsage() {
+	return allocatedBytes + slabs.capacity() * (sizeof(char *) + 3 * sizeof(uint32_t)) + slabMarked.capacity() / 8;
+}
+
+/**
+ * FUNCTION NAME: markForCompaction
+ *
+ * DESCRIPTION: Mark the sealed slabs with at least ARENA_COMPACT_RATIO dead bytes.
+ * 				Live strings in marked slabs are moved by the caller, then freeMarked() runs.
+ *
+ * RETURNS:
+ * number of slabs marked
+ */
+uint32_t SlabArena::markForCompaction() {
+	uint32_t marked = 0;
+	for ( uint32_t i = 0; i < slabs.size(); i++ ) {
+		if ( slabSpan[i] && i != current && (slabUsed[i] - slabLive[i]) >= slabUsed[i] * ARENA_COMPACT_RATIO ) {
+			slabMarked[i] = true;
+			marked++;
+		}
+	}
+	return marked;
+}
+
+/**
+ * FUNCTION NAME: isMarked
+ *
+ * DESCRIPTION: Whether the string lives in a slab being evacuated
+ */
+bool SlabArena::isMarked(uint32_t ref) {
+	return slabMarked[ref / ARENA_SLAB_SIZE];
+}
+
+/**
+ * FUNCTION NAME: freeMarked
+ *
+ * DESCRIPTION: End of an evacuation. Marked slabs normally went away when their last string was released.
+ */
+void SlabArena::freeMarked() {
+	for ( uint32_t i = 0; i < slabs.size(); i++ ) {
+		if ( slabMarked[i] ) {
+			if ( slabLive[i] == 0 ) {
+				freeSlab(i);
+			}
+			else {
+				slabMarked[i] = false;
+			}
+		}
+	}
+}
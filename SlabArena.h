@@ -0,0 +1,66 @@
+/**********************************
+ * FILE NAME: SlabArena.h
+ *
+ * DESCRIPTION: Header file of the SlabArena class
+ **********************************/
+
+#ifndef SLABARENA_H_
+#define SLABARENA_H_
+
+#include "stdincludes.h"
+#include <stdint.h>
+#include <string_view>
+
+/*
+ * Macros
+ */
+#define ARENA_SLAB_SIZE (64 * 1024)
+// never a valid reference: offsets stop short of the last slab window
+#define ARENA_NULL_REF 0xFFFFFFFFU
+// a slab whose dead bytes reach this fraction of what was written in it is worth evacuating
+#define ARENA_COMPACT_RATIO 0.5
+
+/**
+ * CLASS NAME: SlabArena
+ *
+ * DESCRIPTION: Append-only storage for short strings. Each string is stored
+ * 				as a varint length prefix followed by its bytes, and is referred
+ * 				to by a 32-bit offset: slab index * ARENA_SLAB_SIZE + position.
+ * 				Strings are never modified in place; a released string becomes
+ * 				dead bytes until its slab is evacuated (see HashTable::compactStep)
+ * 				or every string in the slab is released.
+ */
+class SlabArena {
+private:
+	// slab index -> start of its ARENA_SLAB_SIZE window, NULL if free.
+	// A string longer than a slab gets several consecutive indices over one buffer.
+	vector<char *> slabs;
+	// per slab: bytes written, bytes still live, indices spanned, marked for evacuation
+	vector<uint32_t> slabUsed;
+	vector<uint32_t> slabLive;
+	vector<uint32_t> slabSpan;
+	vector<bool> slabMarked;
+	vector<uint32_t> freeSlabs;
+	// slab strings are appended to
+	uint32_t current;
+	size_t liveBytes;
+	size_t deadBytes;
+	size_t allocatedBytes;
+
+	uint32_t newSlab(uint32_t span);
+	void freeSlab(uint32_t index);
+
+public:
+	SlabArena();
+	virtual ~SlabArena();
+	uint32_t put(string_view s);
+	string_view get(uint32_t ref);
+	void release(uint32_t ref);
+	double fragmentation();
+	size_t memoryUsage();
+	uint32_t markForCompaction();
+	bool isMarked(uint32_t ref);
+	void freeMarked();
+};
+
+#endif /* SLABARENA_H_ */
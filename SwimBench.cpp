@@ -0,0 +1,201 @@
+/**********************************
+ * FILE NAME: SwimBench.cpp
+ *
+ * DESCRIPTION: Per-node load and failure detection time of the membership protocols:
+ * 				heartbeat gossip to about 70% of the members, heartbeat gossip to
+ * 				GOSSIP_FANOUT members, either with a fixed TREMOVE or a phi-accrual
+ * 				timeout, and SWIM. Every node starts with the full membership list,
+ * 				the load is measured over WINDOW ticks, then one node fails and the
+ * 				run goes on until every other node removed it. Detection is the ticks
+ * 				until the first and the last node removed it, false removals are the
+ * 				times a live node removed another live node. Then the detection and
+ * 				false removals of heartbeat gossip against the message drop probability.
+ *
+ * RUN PROCEDURE:
+ * $ make bench
+ * $ ./SwimBench [cluster sizes, default 100 1000]
+ **********************************/
+
+#include "BenchCluster.h"
+
+/*
+ * Macros
+ */
+// ticks before measuring the load, then ticks measured
+#define WARMUP 30
+#define WINDOW 20
+// ticks the failure is given to be detected by every node
+#define DETECTION_LIMIT 300
+// heartbeat gossip sends O(members) entries to O(members) peers a tick, too slow past this size
+#define GOSSIP_MAX_NODES 100
+// cluster size of the drop probability table
+#define DROP_NODES 100
+
+/**
+ * STRUCT NAME: Protocol
+ *
+ * DESCRIPTION: A membership protocol configuration
+ */
+struct Protocol {
+	const char *name;
+	int membership;
+	int fanout;
+	double phi;
+};
+
+/**
+ * STRUCT NAME: Result
+ *
+ * DESCRIPTION: Load and detection of one run, -1 for a detection that did not happen
+ */
+struct Result {
+	double messagesPerNode;
+	double bytesPerNode;
+	int firstDetection;
+	int lastDetection;
+	long falseRemovals;
+};
+
+/**
+ * CLASS NAME: RemovalCounter
+ *
+ * DESCRIPTION: Counts the removals of live nodes the nodes it is subscribed to report
+ */
+class RemovalCounter : public MembershipListener {
+public:
+	Address failed;
+	long removals;
+	RemovalCounter(): removals(0) {}
+	void onLeave(Address &addr, bool left) {
+		removals += !(addr == failed);
+	}
+};
+
+/**
+ * FUNCTION NAME: lists
+ *
+ * DESCRIPTION: Live nodes whose membership list has the given node
+ */
+static int lists(vector<MP1Node *> &nodes, Address &addr) {
+	int count = 0;
+	for ( MP1Node *node : nodes ) {
+		if ( !node->getMemberNode()->bFailed ) {
+			count += node->getMemberNode()->members.find(addr.getId(), addr.getPort()) >= 0;
+		}
+	}
+	return count;
+}
+
+/**
+ * FUNCTION NAME: sent
+ *
+ * DESCRIPTION: Messages and bytes the membership protocol sent so far
+ */
+static pair<long, long> sent(Metrics *metrics) {
+	pair<long, long> total(0, 0);
+	for ( const char *type : {"JOINREQ", "JOINREP", "HEARTBEAT", "PING", "PINGREQ", "ACK"} ) {
+		total.first += metrics->counter("messages_sent_total", "", Metrics::label("type", type))->get();
+		total.second += metrics->counter("message_bytes_sent_total", "", Metrics::label("type", type))->get();
+	}
+	return total;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Application::mp1Run for n nodes that all start with the full membership list
+ */
+static Result run(int n, Protocol &protocol, double drop) {
+	BenchCluster cluster(n, 0, drop);
+	Params *par = cluster.par;
+	par->GOSSIP_FANOUT = protocol.fanout;
+	par->MEMBERSHIP = protocol.membership;
+	par->PHI_THRESHOLD = protocol.phi;
+	cluster.start();
+	cluster.fullMembership();
+	Metrics *metrics = cluster.metrics;
+	vector<MP1Node *> &nodes = cluster.nodes;
+
+	Result result = {0, 0, -1, -1, 0};
+	MP1Node *failed = nodes[n / 2];
+	RemovalCounter counter;
+	counter.failed = failed->getMemberNode()->addr;
+	for ( MP1Node *node : nodes ) {
+		node->subscribe(&counter);
+	}
+	int failTime = WARMUP + WINDOW;
+	pair<long, long> before(0, 0);
+	for ( par->globaltime = 0; par->globaltime < failTime + DETECTION_LIMIT; par->globaltime++ ) {
+		if ( par->globaltime == WARMUP ) {
+			before = sent(metrics);
+		}
+		if ( par->globaltime == failTime ) {
+			pair<long, long> after = sent(metrics);
+			result.messagesPerNode = (double)(after.first - before.first) / WINDOW / n;
+			result.bytesPerNode = (double)(after.second - before.second) / WINDOW / n;
+			failed->getMemberNode()->bFailed = true;
+		}
+		cluster.tick();
+		if ( par->globaltime >= failTime ) {
+			int listing = lists(nodes, failed->getMemberNode()->addr);
+			if ( result.firstDetection < 0 && listing < n - 1 ) {
+				result.firstDetection = par->globaltime - failTime;
+			}
+			if ( 0 == listing ) {
+				result.lastDetection = par->globaltime - failTime;
+				break;
+			}
+		}
+	}
+
+	result.falseRemovals = counter.removals;
+	return result;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: main function. Start from here
+ **********************************/
+int main(int argc, char *argv[]) {
+	vector<int> sizes;
+	for ( int i = 1; i < argc; i++ ) {
+		sizes.push_back(min(atoi(argv[i]), MAX_NODES));
+	}
+	if ( sizes.empty() ) {
+		sizes = {100, MAX_NODES};
+	}
+	srand(1);
+
+	vector<Protocol> protocols = {
+		{"heartbeat", GOSSIP_MEMBERSHIP, 0, 0},
+		{"heartbeat k=3", GOSSIP_MEMBERSHIP, 3, 0},
+		{"k=3 phi=8", GOSSIP_MEMBERSHIP, 3, 8},
+		{"swim", SWIM_MEMBERSHIP, 0, 0},
+	};
+	printf("%6s %14s %12s %12s %10s %10s %8s\n", "nodes", "protocol", "msgs/node", "B/node", "first", "all", "false");
+	for ( int n : sizes ) {
+		for ( Protocol &protocol : protocols ) {
+			if ( GOSSIP_MEMBERSHIP == protocol.membership && n > GOSSIP_MAX_NODES ) {
+				printf("%6d %14s %12s\n", n, protocol.name, "skipped");
+				continue;
+			}
+			Result result = run(n, protocol, 0);
+			printf("%6d %14s %12.2f %12.1f %10d %10d %8ld\n", n, protocol.name, result.messagesPerNode,
+					result.bytesPerNode, result.firstDetection, result.lastDetection, result.falseRemovals);
+		}
+	}
+
+	printf("\nHeartbeat gossip with GOSSIP_FANOUT 3 for %d nodes against the drop probability\n", DROP_NODES);
+	printf("%6s %14s %10s %10s %8s\n", "drop", "timeout", "first", "all", "false");
+	for ( double drop : {0.0, 0.1, 0.2, 0.3} ) {
+		for ( double phi : {0.0, 4.0, 8.0, 12.0} ) {
+			Protocol protocol = {"", GOSSIP_MEMBERSHIP, 3, phi};
+			Result result = run(DROP_NODES, protocol, drop);
+			string timeout = phi > 0 ? "phi=" + to_string((int)phi) : "TREMOVE";
+			printf("%6.2f %14s %10d %10d %8ld\n", drop, timeout.c_str(), result.firstDetection, result.lastDetection,
+					result.falseRemovals);
+		}
+	}
+	return SUCCESS;
+}
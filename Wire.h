@@ -0,0 +1,110 @@
+/**********************************
+ * FILE NAME: Wire.h
+ *
+ * DESCRIPTION: Cursors used to encode and decode the messages of the membership
+ * 				protocol and the KV store: bytes, varints, zigzag integers, 8-byte
+ * 				little-endian words and varint-length strings
+ **********************************/
+
+#ifndef WIRE_H_
+#define WIRE_H_
+
+#include "stdincludes.h"
+#include <stdint.h>
+#include <string_view>
+
+/**
+ * CLASS NAME: WireWriter
+ *
+ * DESCRIPTION: Cursor over a caller's buffer. Writes past the end are dropped and clear ok.
+ */
+class WireWriter {
+public:
+	char *p;
+	char *end;
+	bool ok;
+	void byte(uint8_t b) {
+		if (p < end)
+			*p++ = b;
+		else
+			ok = false;
+	}
+	void varint(uint64_t v) {
+		while (v >= 0x80) {
+			byte(v | 0x80);
+			v >>= 7;
+		}
+		byte(v);
+	}
+	void zigzag(int v) {
+		varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+	}
+	void u64(uint64_t v) {
+		for (int i = 0; i < 8; i++)
+			byte(v >> (8 * i));
+	}
+	void bytes(const void *data, size_t n) {
+		if ((size_t)(end - p) < n) {
+			ok = false;
+			p = end;
+			return;
+		}
+		memcpy(p, data, n);
+		p += n;
+	}
+	void str(string_view s) {
+		varint(s.size());
+		bytes(s.data(), s.size());
+	}
+};
+
+/**
+ * CLASS NAME: WireReader
+ *
+ * DESCRIPTION: Cursor over a received buffer. Reads past the end return 0 and clear ok.
+ */
+class WireReader {
+public:
+	const char *p;
+	const char *end;
+	bool ok;
+	uint8_t byte() {
+		if (p < end)
+			return *p++;
+		ok = false;
+		return 0;
+	}
+	uint64_t varint() {
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t b = byte();
+			v |= (uint64_t)(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		ok = false;
+		return 0;
+	}
+	int zigzag() {
+		uint32_t v = varint();
+		return (int)((v >> 1) ^ (0U - (v & 1)));
+	}
+	uint64_t u64() {
+		uint64_t v = 0;
+		for (int i = 0; i < 8; i++)
+			v |= (uint64_t)byte() << (8 * i);
+		return v;
+	}
+	string_view str() {
+		uint64_t n = varint();
+		if (!ok || n > (uint64_t)(end - p)) {
+			ok = false;
+			return string_view();
+		}
+		string_view s(p, n);
+		p += n;
+		return s;
+	}
+};
+
+#endif /* WIRE_H_ */
@@ -10,7 +10,6 @@
 /*
  * Macros
  */
-#define RING_SIZE 512
 #define FAILURE -1
 #define SUCCESS 0
 
@@ -19,6 +18,7 @@
  */
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>